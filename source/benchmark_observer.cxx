@@ -0,0 +1,199 @@
+
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkImageRegistrationMethod.h>
+#include <itkMattesMutualInformationImageToImageMetric.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkTranslationTransform.h>
+#include <itkRegularStepGradientDescentOptimizer.h>
+#include <itkCommand.h>
+#include <itkTimeProbe.h>
+
+#include "sziOptimizerValueTracker.h"
+#include "sziLogService.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+typedef itk::Image<float,3> ImageType;
+typedef itk::ImageRegistrationMethod<ImageType,ImageType> RegistrationType;
+typedef itk::RegularStepGradientDescentOptimizer OptimizerType;
+
+// Iteration observer doing the bookkeeping of RegistrationSystem::Execute(), either by evaluating
+// the metric again at the current position or by reading the value the optimizer has computed.
+class IterationObserver : public itk::Command
+{
+public:
+    typedef IterationObserver Self;
+    typedef itk::Command Superclass;
+    typedef itk::SmartPointer< Self > Pointer;
+
+    itkFactorylessNewMacro( Self );
+
+    void setReevaluate( bool reevaluate ) { this->m_Reevaluate = reevaluate; }
+
+    void reset()
+    {
+        this->m_IterCount = 0;
+        this->m_FinalValue = 0;
+        this->m_ValueTracker.reset();
+    }
+
+    int getIterCount() const { return this->m_IterCount; }
+    double getFinalValue() const { return this->m_FinalValue; }
+
+    virtual void Execute( itk::Object * caller, const itk::EventObject & eo )
+    {
+        this->Execute( (const itk::Object *)caller, eo );
+    }
+
+    virtual void Execute( const itk::Object * caller, const itk::EventObject & eo )
+    {
+        const OptimizerType* optimizer = dynamic_cast<const OptimizerType*>( caller );
+        if ( optimizer == 0 || !itk::IterationEvent().CheckEvent( &eo ) ) return;
+
+        OptimizerType::ParametersType params;
+        double value = 0;
+        if ( this->m_Reevaluate || !this->m_ValueTracker.update( optimizer, params, value ) )
+        {
+            params = optimizer->GetCurrentPosition();
+            value = optimizer->GetValue( params );
+        }
+
+        if ( this->m_IterCount == 0 || this->m_FinalValue > value )
+        {
+            this->m_FinalValue = value;
+        }
+        this->m_IterCount++;
+    }
+
+protected:
+    IterationObserver() : m_Reevaluate(false), m_IterCount(0), m_FinalValue(0) {}
+
+private:
+    bool m_Reevaluate;
+    int m_IterCount;
+    double m_FinalValue;
+    szi::OptimizerValueTracker m_ValueTracker;
+};
+
+// Return a synthetic image of a smooth blob centered at the given position (in pixels).
+static ImageType::Pointer createImage( unsigned int size, double cx, double cy, double cz )
+{
+    ImageType::RegionType region;
+    region.SetSize( 0, size );
+    region.SetSize( 1, size );
+    region.SetSize( 2, size );
+
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions( region );
+    image->Allocate();
+
+    double sigma = size / 6.0;
+    itk::ImageRegionIteratorWithIndex<ImageType> it( image, region );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+        const ImageType::IndexType& index = it.GetIndex();
+        double dx = index[0] - cx, dy = index[1] - cy, dz = index[2] - cz;
+        double r2 = ( dx * dx + dy * dy + dz * dz ) / ( sigma * sigma );
+        it.Set( (float)( 100 * std::exp( -0.5 * r2 ) + 10 * std::sin( 0.3 * index[0] ) * std::cos( 0.2 * index[1] ) ) );
+    }
+    return image;
+}
+
+// Time the registration of two synthetic images with the iteration observer either evaluating the
+// metric again at each iteration, as the observers of RegistrationSystem and SystemParametersTuner
+// used to, or reading the value computed by the optimizer through OptimizerValueTracker.
+// The images, the metric samples and the number of iterations are fixed, so the runs are comparable.
+int main ( int argc, char** argv )
+{
+    szi::getSystemLogger().SetName( "benchmark_observer" );
+    szi::getSystemLogger().StartLogging( "benchmark_observer" );
+
+    int retcode = 0;
+
+    try
+    {
+        unsigned int iterations = ( argc > 1 ? (unsigned int)atoi( argv[1] ) : 100 );
+        unsigned int samples = ( argc > 2 ? (unsigned int)atoi( argv[2] ) : 50000 );
+        unsigned int repeats = ( argc > 3 ? (unsigned int)atoi( argv[3] ) : 3 );
+        if ( repeats < 1 ) repeats = 1;
+        unsigned int size = 64;
+
+        ImageType::Pointer fixed = createImage( size, size / 2.0, size / 2.0, size / 2.0 );
+        ImageType::Pointer moving = createImage( size, size / 2.0 + 4, size / 2.0 - 3, size / 2.0 + 2 );
+
+        typedef itk::MattesMutualInformationImageToImageMetric<ImageType,ImageType> MetricType;
+        typedef itk::LinearInterpolateImageFunction<ImageType,double> InterpolatorType;
+        typedef itk::TranslationTransform<double,3> TransformType;
+
+        IterationObserver::Pointer observer = IterationObserver::New();
+
+        std::cout << "iterations " << iterations << ", samples " << samples << ", repeats " << repeats << std::endl;
+
+        double total[2] = { 0, 0 };
+        for ( unsigned int r = 0; r < repeats; r++ )
+        {
+            for ( int mode = 0; mode < 2; mode++ )
+            {
+                MetricType::Pointer metric = MetricType::New();
+                metric->SetNumberOfHistogramBins( 50 );
+                metric->SetNumberOfFixedImageSamples( samples );
+                metric->ReinitializeSeed( 76926294 );
+
+                TransformType::Pointer transform = TransformType::New();
+                transform->SetIdentity();
+
+                OptimizerType::Pointer optimizer = OptimizerType::New();
+                optimizer->SetMaximumStepLength( 1.0 );
+                optimizer->SetMinimumStepLength( 1e-12 );
+                optimizer->SetGradientMagnitudeTolerance( 0 );
+                optimizer->SetNumberOfIterations( iterations );
+
+                RegistrationType::Pointer registration = RegistrationType::New();
+                registration->SetMetric( metric );
+                registration->SetOptimizer( optimizer );
+                registration->SetTransform( transform );
+                registration->SetInterpolator( InterpolatorType::New() );
+                registration->SetFixedImage( fixed );
+                registration->SetMovingImage( moving );
+                registration->SetFixedImageRegion( fixed->GetBufferedRegion() );
+                registration->SetInitialTransformParameters( transform->GetParameters() );
+
+                observer->setReevaluate( mode == 0 );
+                observer->reset();
+                optimizer->AddObserver( itk::IterationEvent(), observer );
+
+                itk::TimeProbe probe;
+                probe.Start();
+                registration->Update();
+                probe.Stop();
+
+                total[mode] += probe.GetTotal();
+
+                std::cout << ( mode == 0 ? "re-evaluating observer: " : "tracking observer:      " )
+                          << probe.GetTotal() << " s for " << observer->getIterCount() << " iterations, best value "
+                          << observer->getFinalValue() << std::endl;
+            }
+        }
+
+        std::cout << "mean time re-evaluating " << total[0] / repeats << " s, tracking " << total[1] / repeats
+                  << " s, saved " << ( total[0] > 0 ? 100 * ( total[0] - total[1] ) / total[0] : 0 ) << "%" << std::endl;
+
+        retcode = EXIT_SUCCESS;
+    }
+    catch ( itk::ExceptionObject& e )
+    {
+        std::cerr << e << std::endl;
+        retcode = EXIT_FAILURE;
+    }
+    catch ( ... )
+    {
+        retcode = EXIT_FAILURE;
+    }
+
+    szi::getSystemLogger().EndLogging();
+
+    return retcode;
+}
@@ -0,0 +1,75 @@
+
+#include <itkDOMNodeXMLReader.h>
+
+#include "sziRegistrationSystem.h"
+#include "sziDataSetDOMReader.h"
+#include "sziImagePack.h"
+#include "sziLogService.h"
+
+// Read and crop the images of all training examples of a tuning job into a pack file,
+// to be set as the "ImagePack" attribute of the "RegistrationSystem" tag of the job.
+int main ( int argc, char** argv )
+{
+    szi::getSystemLogger().SetName( "pack_data" );
+    szi::getSystemLogger().StartLogging( argc > 2 ? argv[2] : "pack_data" );
+
+    int retcode = 0;
+
+    try
+    {
+        if ( argc < 3 )
+        {
+            szi::getSystemLogger() << szi::Fatal << "Usage: pack_data <job>.spt.xml <output pack file>" << szi::End;
+        }
+
+        // read the training examples of the job
+        typedef itk::DOMNodeXMLReader DOMReaderType;
+        DOMReaderType::Pointer domReader = DOMReaderType::New();
+        domReader->SetFileName( argv[1] );
+        domReader->Update();
+
+        const itk::DOMNode* node = domReader->GetOutput()->GetChildByID( "data" );
+        if ( node == 0 )
+        {
+            szi::getSystemLogger() << szi::Fatal << "DataSet (training examples) is not available!" << szi::End;
+        }
+
+        typedef szi::DataSet<szi::SystemData> DataSetType;
+        typedef szi::DataSetDOMReader<DataSetType> DataSetReaderType;
+        DataSetReaderType::Pointer reader = DataSetReaderType::New();
+        reader->Update( node );
+        DataSetType* examples = reader->GetOutput();
+
+        // read and crop the images of each example into the pack
+        typedef szi::RegistrationSystem SystemType;
+        SystemType::Pointer system = SystemType::New();
+
+        szi::ImagePack::Pointer pack = szi::ImagePack::New();
+        pack->create( argv[2] );
+
+        for ( size_t i = 0; i < examples->size(); i++ )
+        {
+            SystemType::DataType* data = dynamic_cast<SystemType::DataType*>( (szi::SystemData*)examples->at(i) );
+            if ( data == 0 )
+            {
+                szi::getSystemLogger() << szi::Warning << "Training example " << i << " is not registration data and is skipped!" << szi::End;
+                continue;
+            }
+
+            system->setData( data );
+            system->packData( pack );
+        }
+
+        pack->close();
+
+        retcode = EXIT_SUCCESS;
+    }
+    catch ( ... )
+    {
+        retcode = EXIT_FAILURE;
+    }
+
+    szi::getSystemLogger().EndLogging();
+
+    return retcode;
+}
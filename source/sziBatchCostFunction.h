@@ -0,0 +1,96 @@
+#ifndef _sziBatchCostFunction_h_
+#define _sziBatchCostFunction_h_
+
+#include <itkSingleValuedCostFunction.h>
+#include <vector>
+
+namespace szi
+{
+
+    /**
+    Abstract class (interface) to represent any cost function that is able to compute the values
+    for a number of parameter settings at once, for example by distributing the computations over
+    a cluster of workers. Population-based optimizers use it to evaluate a whole generation in one call.
+    */
+    class BatchCostFunction
+    {
+    public:
+        typedef itk::SingleValuedCostFunction::ParametersType ParametersType;
+        typedef itk::SingleValuedCostFunction::MeasureType MeasureType;
+
+        typedef std::vector<ParametersType> ParametersListType;
+        typedef std::vector<MeasureType> MeasureListType;
+
+        /** Interface to be told the value of each setting of a batch as soon as it is known, e.g. to record it. */
+        class ValueObserver
+        {
+        public:
+            virtual void valueComputed( unsigned int i, MeasureType value ) = 0;
+
+            virtual ~ValueObserver() {}
+        };
+
+        /**
+        Abstract method to be implemented in subclasses to compute the values
+        for all the input parameter settings, in the same order.
+        */
+        virtual void GetValues( const ParametersListType& params, MeasureListType& values ) const = 0;
+
+        /**
+        Compute the values for all the input parameter settings, telling the observer (if not null) the value
+        of each setting as soon as it is known. By default, the observer is told all the values at the end;
+        subclasses computing the settings one after another should override it.
+        */
+        virtual void GetValues( const ParametersListType& params, MeasureListType& values, ValueObserver* observer ) const
+        {
+            this->GetValues( params, values );
+            for ( size_t i = 0; observer && i < values.size(); i++ )
+            {
+                observer->valueComputed( i, values[i] );
+            }
+        }
+
+        /**
+        Return whether the values are the costs of the settings themselves, or false if some of them may
+        be bounds or estimates, e.g. when hopeless settings are stopped early or screened at a low fidelity.
+        */
+        virtual bool getValuesAreExact() const { return true; }
+
+        virtual ~BatchCostFunction() {}
+    };
+
+    /**
+    Compute the values of a cost function for a list of parameter settings, in one batch if
+    the cost function supports it, or one after another otherwise, telling the observer (if not null)
+    the value of each setting as soon as it is known.
+    */
+    inline void GetCostFunctionValues( const itk::SingleValuedCostFunction* costfunc,
+                                       const BatchCostFunction::ParametersListType& params,
+                                       BatchCostFunction::MeasureListType& values,
+                                       BatchCostFunction::ValueObserver* observer = 0 )
+    {
+        const BatchCostFunction* batch = dynamic_cast<const BatchCostFunction*>( costfunc );
+        if ( batch )
+        {
+            batch->GetValues( params, values, observer );
+            return;
+        }
+
+        values.resize( params.size() );
+        for ( size_t i = 0; i < params.size(); i++ )
+        {
+            values[i] = costfunc->GetValue( params[i] );
+            if ( observer ) observer->valueComputed( i, values[i] );
+        }
+    }
+
+    /** Return whether the values of a cost function are exact, see BatchCostFunction::getValuesAreExact(). */
+    inline bool GetCostFunctionValuesAreExact( const itk::SingleValuedCostFunction* costfunc )
+    {
+        const BatchCostFunction* batch = dynamic_cast<const BatchCostFunction*>( costfunc );
+        return ( batch == 0 || batch->getValuesAreExact() );
+    }
+
+} // namespace szi
+
+#endif // _sziBatchCostFunction_h_
@@ -0,0 +1,376 @@
+#ifndef _sziBatchExhaustiveOptimizer_h_
+#define _sziBatchExhaustiveOptimizer_h_
+
+#include <itkExhaustiveOptimizer.h>
+#include <itkNumericTraits.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sziBatchCostFunction.h"
+#include "sziCheckpointable.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    /**
+    Exhaustive optimizer that evaluates the grid points in batches.
+    It walks the same grid as itk::ExhaustiveOptimizer, but passes a batch of grid points
+    at a time to the cost function, such that a cost function implementing BatchCostFunction
+    (e.g. SystemTrainingMetric) can compute their values at the same time. An iteration event
+    is invoked after each batch, with the current position set to the best point so far.
+    The walk can be saved to a checkpoint after each batch, and resumed from the next grid point.
+    Optionally, the value of each grid point is appended to a CSV results file as soon as it is computed, to map
+    the landscape of the cost function; the grid points already in the file are skipped, such that an
+    interrupted sweep resumes from the file even without a checkpoint.
+    */
+    class BatchExhaustiveOptimizer : public itk::ExhaustiveOptimizer, public Checkpointable
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BatchExhaustiveOptimizer Self;
+        typedef itk::ExhaustiveOptimizer Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BatchExhaustiveOptimizer, ExhaustiveOptimizer );
+
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+
+        /**
+        Set/get the number of grid points evaluated in one batch.
+        Zero (the default) means the whole grid at once.
+        */
+        void setBatchSize( unsigned int n ) { this->m_BatchSize = n; }
+        unsigned int getBatchSize() const { return this->m_BatchSize; }
+
+        /** Set/get the CSV file the value of each grid point is appended to, or an empty name (the default) for none. */
+        void setResultsFileName( const std::string& fn ) { this->m_ResultsFileName = fn; }
+        const std::string& getResultsFileName() const { return this->m_ResultsFileName; }
+
+        /** Return the best value found and its position. */
+        MeasureType getBestValue() const { return this->m_BestValue; }
+        const ParametersType& getBestPosition() const { return this->m_BestPosition; }
+
+        /** Checkpointable method to write the index of the next grid point, and the best point so far. */
+        virtual void saveState( StreamBuffer& sb ) const
+        {
+            sb << this->m_NumberOfPoints;
+            sb << this->m_NextPoint;
+            sb << this->m_BestValue;
+            sb << (const itk::Array<double>&)this->m_BestPosition;
+        }
+
+        /** Checkpointable method to read the state written by saveState(), such that the next optimization resumes the walk. */
+        virtual void restoreState( StreamBuffer& sb )
+        {
+            sb >> this->m_NumberOfPoints;
+            sb >> this->m_NextPoint;
+            sb >> this->m_BestValue;
+            sb >> (itk::Array<double>&)this->m_BestPosition;
+            this->m_Restored = true;
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "restoreState(): resuming at grid point " << this->m_NextPoint << " of " << this->m_NumberOfPoints << End;
+        }
+
+        virtual void StartOptimization()
+        {
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): =====start=====" << End;
+
+            this->InvokeEvent( itk::StartEvent() );
+
+            const ParametersType& initial = this->GetInitialPosition();
+            const StepsType& steps = this->GetNumberOfSteps();
+            unsigned int n = initial.GetSize();
+
+            if ( steps.GetSize() != n )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "StartOptimization(): NumberOfSteps does not match the number of parameters" << End;
+            }
+
+            ScalesType scales = this->GetScales();
+            if ( scales.GetSize() != n )
+            {
+                scales.SetSize( n );
+                scales.Fill( 1.0 );
+            }
+
+            // total number of grid points
+            unsigned long npoints = 1;
+            for ( unsigned int i = 0; i < n; i++ )
+            {
+                npoints *= ( 2 * (unsigned long)steps[i] + 1 );
+            }
+
+            unsigned long batchsize = this->m_BatchSize ? this->m_BatchSize : npoints;
+
+            // the values of a cost function stopping or screening settings early are not those of the landscape
+            if ( !this->m_ResultsFileName.empty() && !GetCostFunctionValuesAreExact( this->m_CostFunction ) )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "StartOptimization(): ResultsFileName requires the exact values of the grid points, "
+                                  << "switch off racing and multi-fidelity screening of the cost function" << End;
+            }
+
+            // resume the walk from a restored checkpoint of the same grid, or start over
+            unsigned long start = 0;
+            if ( this->m_Restored && this->m_NumberOfPoints == npoints && this->m_BestPosition.GetSize() == n )
+            {
+                start = std::min( this->m_NextPoint, npoints );
+            }
+            else
+            {
+                if ( this->m_Restored )
+                {
+                    getSystemLogger() << StartWarning(this->GetNameOfClass()) << "StartOptimization(): restored state does not match the grid, starting over" << End;
+                }
+                this->m_BestValue = itk::NumericTraits<MeasureType>::max();
+                this->m_BestPosition = initial;
+            }
+            this->m_Restored = false;
+            this->m_NumberOfPoints = npoints;
+
+            // grid points already in the results file
+            std::vector<bool> done;
+            this->openResultsFile( initial, steps, scales, npoints, done );
+
+            unsigned long ndone = start;
+            for ( unsigned long p = start; p < done.size(); p++ )
+            {
+                if ( done[p] ) ndone++;
+            }
+
+            // index of the first grid point, the first parameter varying fastest
+            itk::Array<unsigned long> index( n );
+            unsigned long rest = start;
+            for ( unsigned int i = 0; i < n; i++ )
+            {
+                unsigned long size = 2 * (unsigned long)steps[i] + 1;
+                index[i] = rest % size;
+                rest /= size;
+            }
+
+            unsigned long next = start;
+            while ( next < npoints )
+            {
+                // positions of the grid points in this batch, skipping those in the results file
+                ParametersListType params;
+                std::vector<unsigned long> points;
+                for ( ; next < npoints && points.size() < batchsize; next++ )
+                {
+                    if ( next >= done.size() || !done[next] )
+                    {
+                        ParametersType position( n );
+                        for ( unsigned int i = 0; i < n; i++ )
+                        {
+                            position[i] = initial[i] + ( (double)index[i] - steps[i] ) * this->GetStepLength() * scales[i];
+                        }
+                        params.push_back( position );
+                        points.push_back( next );
+                    }
+
+                    // advance to the next grid point, the first parameter varying fastest
+                    for ( unsigned int i = 0; i < n; i++ )
+                    {
+                        if ( ++index[i] <= 2 * (unsigned long)steps[i] ) break;
+                        index[i] = 0;
+                    }
+                }
+
+                // the value of each grid point is written to the results file as soon as it is computed
+                ResultsWriter writer( this, points, params );
+                MeasureListType values;
+                if ( !params.empty() )
+                {
+                    GetCostFunctionValues( this->m_CostFunction, params, values, ( this->m_ResultsFile.is_open() ? &writer : 0 ) );
+                }
+
+                for ( unsigned long b = 0; b < params.size(); b++ )
+                {
+                    if ( values[b] < this->m_BestValue )
+                    {
+                        this->m_BestValue = values[b];
+                        this->m_BestPosition = params[b];
+                    }
+                }
+
+                ndone += params.size();
+                this->m_NextPoint = next;
+
+                this->SetCurrentPosition( this->m_BestPosition );
+                this->InvokeEvent( itk::IterationEvent() );
+
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): " << ndone << " of " << npoints << " grid points evaluated, best value = " << this->m_BestValue << End;
+            }
+
+            this->m_ResultsFile.close();
+
+            this->InvokeEvent( itk::EndEvent() );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): -----e-n-d-----" << End;
+        }
+
+    protected:
+        BatchExhaustiveOptimizer() : m_BatchSize(0), m_BestValue(0), m_NumberOfPoints(0), m_NextPoint(0), m_Restored(false) {}
+
+        /**
+        Open the results file for appending, after reading the grid points it already holds into done, and
+        taking their values into account for the best point. A new file starts with a line describing the grid,
+        which must match for the file to be reused.
+        */
+        void openResultsFile( const ParametersType& initial, const StepsType& steps, const ScalesType& scales, unsigned long npoints, std::vector<bool>& done )
+        {
+            done.clear();
+            if ( this->m_ResultsFileName.empty() ) return;
+
+            std::ostringstream oss;
+            oss.precision( 17 );
+            oss << "# grid " << npoints << " points, StepLength " << this->GetStepLength();
+            for ( unsigned int i = 0; i < initial.GetSize(); i++ )
+            {
+                oss << ", " << initial[i] << " " << steps[i] << " " << scales[i];
+            }
+            std::string signature = oss.str();
+
+            unsigned long nread = 0;
+            bool exists = false;
+            std::ifstream ifs( this->m_ResultsFileName.c_str(), std::ios::in | std::ios::binary );
+            std::string line;
+            std::string complete; // the complete lines of the file
+            if ( ifs && std::getline( ifs, line ) && !ifs.eof() )
+            {
+                exists = true;
+                if ( line != signature )
+                {
+                    getSystemLogger() << StartFatal(this->GetNameOfClass()) << "openResultsFile(): \"" << this->m_ResultsFileName << "\" holds the results of another grid" << End;
+                }
+                complete = line + "\n";
+
+                done.assign( npoints, false );
+                // the column names, and then one line "point,value,parameters..." per grid point; a last line
+                // without its end of line has been cut by an interruption, and is neither read nor kept
+                while ( std::getline( ifs, line ) && !ifs.eof() )
+                {
+                    complete += line + "\n";
+
+                    std::istringstream iss( line );
+                    unsigned long point = 0;
+                    MeasureType value = 0;
+                    char comma = 0;
+                    if ( !( iss >> point >> comma >> value ) || comma != ',' || point >= npoints ) continue;
+
+                    ParametersType position( initial.GetSize() );
+                    for ( unsigned int i = 0; i < position.GetSize() && iss; i++ )
+                    {
+                        if ( iss >> comma && comma != ',' ) iss.setstate( std::ios::failbit );
+                        iss >> position[i];
+                    }
+                    if ( !iss || !( iss >> std::ws ).eof() ) continue;
+
+                    if ( !done[point] ) nread++;
+                    done[point] = true;
+                    if ( value < this->m_BestValue )
+                    {
+                        this->m_BestValue = value;
+                        this->m_BestPosition = position;
+                    }
+                }
+
+                // drop the cut line, if any, such that the next line is not appended to it
+                if ( !line.empty() && ifs.eof() )
+                {
+                    getSystemLogger() << StartWarning(this->GetNameOfClass()) << "openResultsFile(): dropping the incomplete last line \"" << line << "\"" << End;
+                    ifs.close();
+
+                    std::string tmpname = this->m_ResultsFileName + ".tmp";
+                    std::ofstream ofs( tmpname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+                    ofs << complete;
+                    ofs.close();
+                    if ( !ofs || std::rename( tmpname.c_str(), this->m_ResultsFileName.c_str() ) != 0 )
+                    {
+                        getSystemLogger() << StartFatal(this->GetNameOfClass()) << "openResultsFile(): cannot rewrite \"" << this->m_ResultsFileName << "\"" << End;
+                    }
+                }
+            }
+            ifs.close();
+
+            // a file without a complete first line is started over
+            this->m_ResultsFile.open( this->m_ResultsFileName.c_str(), std::ios::out | ( exists ? std::ios::app : std::ios::trunc ) );
+            if ( !this->m_ResultsFile )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "openResultsFile(): cannot write to \"" << this->m_ResultsFileName << "\"" << End;
+            }
+            this->m_ResultsFile.precision( 17 );
+
+            if ( !exists )
+            {
+                this->m_ResultsFile << signature << std::endl;
+                this->m_ResultsFile << "point,value";
+                for ( unsigned int i = 0; i < initial.GetSize(); i++ )
+                {
+                    this->m_ResultsFile << ",p" << i;
+                }
+                this->m_ResultsFile << std::endl;
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "openResultsFile(): " << nread << " grid points read from \"" << this->m_ResultsFileName << "\"" << End;
+        }
+
+        /** Append the value of a grid point to the results file, flushed right away such that an interrupted sweep loses nothing. */
+        void writeResult( unsigned long point, const ParametersType& position, MeasureType value )
+        {
+            this->m_ResultsFile << point << "," << value;
+            for ( unsigned int i = 0; i < position.GetSize(); i++ )
+            {
+                this->m_ResultsFile << "," << position[i];
+            }
+            this->m_ResultsFile << "\n";
+            this->m_ResultsFile.flush();
+        }
+
+        /** Observer of the values of a batch, writing each of them to the results file as it is computed. */
+        struct ResultsWriter : public BatchCostFunction::ValueObserver
+        {
+            Self* m_Optimizer;
+            const std::vector<unsigned long>& m_Points;
+            const ParametersListType& m_Params;
+
+            ResultsWriter( Self* optimizer, const std::vector<unsigned long>& points, const ParametersListType& params )
+                : m_Optimizer(optimizer), m_Points(points), m_Params(params) {}
+
+            virtual void valueComputed( unsigned int i, MeasureType value )
+            {
+                this->m_Optimizer->writeResult( this->m_Points[i], this->m_Params[i], value );
+            }
+        };
+        friend struct ResultsWriter;
+
+    private:
+        BatchExhaustiveOptimizer( const Self & ); // purposely not implemented
+        BatchExhaustiveOptimizer& operator=( const Self & ); // purposely not implemented
+
+        unsigned int m_BatchSize;
+
+        std::string m_ResultsFileName;
+        std::ofstream m_ResultsFile;
+
+        MeasureType m_BestValue;
+        ParametersType m_BestPosition;
+
+        unsigned long m_NumberOfPoints;
+        unsigned long m_NextPoint;
+        bool m_Restored;
+    };
+
+} // namespace szi
+
+#endif // _sziBatchExhaustiveOptimizer_h_
@@ -0,0 +1,329 @@
+#ifndef _sziBatchParticleSwarmOptimizer_h_
+#define _sziBatchParticleSwarmOptimizer_h_
+
+#include <itkParticleSwarmOptimizer.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkNumericTraits.h>
+
+#include <algorithm>
+
+#include "sziBatchCostFunction.h"
+#include "sziCheckpointable.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    /**
+    Cost function that only reports the number of parameters of another cost function, and
+    returns the worst possible value for any parameters. It is used to let the base class
+    place the initial swarm without evaluating the particles one by one.
+    */
+    class PlaceholderCostFunction : public itk::SingleValuedCostFunction
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef PlaceholderCostFunction Self;
+        typedef itk::SingleValuedCostFunction Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::PlaceholderCostFunction, SingleValuedCostFunction );
+
+        void setNumberOfParameters( unsigned int n ) { this->m_NumberOfParameters = n; }
+
+        virtual unsigned int GetNumberOfParameters() const { return this->m_NumberOfParameters; }
+
+        virtual MeasureType GetValue( const ParametersType& ) const
+        {
+            return itk::NumericTraits<MeasureType>::max();
+        }
+
+        virtual void GetDerivative( const ParametersType&, DerivativeType& ) const
+        {
+        	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GetDerivative(): derivative calculation is not supported" << End;
+        }
+
+    protected:
+        PlaceholderCostFunction() : m_NumberOfParameters(0) {}
+
+    private:
+        PlaceholderCostFunction( const Self & ); // purposely not implemented
+        PlaceholderCostFunction& operator=( const Self & ); // purposely not implemented
+
+        unsigned int m_NumberOfParameters;
+    };
+
+    /**
+    Particle swarm optimizer that evaluates all particles of a generation in one batch.
+    The particles are moved first, and then the whole swarm is passed to the cost function,
+    such that a cost function implementing BatchCostFunction (e.g. SystemTrainingMetric)
+    can compute the values of all particles at the same time. The swarm dynamics are the same
+    as the ones of itk::ParticleSwarmOptimizer.
+    The swarm can be saved to a checkpoint after each iteration; an optimization started after
+    restoring it continues with the restored swarm for the remaining number of iterations.
+    */
+    class BatchParticleSwarmOptimizer : public itk::ParticleSwarmOptimizer, public Checkpointable
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BatchParticleSwarmOptimizer Self;
+        typedef itk::ParticleSwarmOptimizer Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BatchParticleSwarmOptimizer, ParticleSwarmOptimizer );
+
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+
+        /** Return the number of iterations completed, including the ones before a restored checkpoint. */
+        unsigned int getNumberOfCompletedIterations() const { return this->m_CompletedIterations; }
+
+        /** Checkpointable method to write the swarm: positions, velocities and personal bests of the particles. */
+        virtual void saveState( StreamBuffer& sb ) const
+        {
+            sb << this->m_CompletedIterations;
+            sb << (unsigned int)this->m_Particles.size();
+            for ( unsigned int j = 0; j < this->m_Particles.size(); j++ )
+            {
+                const ParticleData& p = this->m_Particles[j];
+                sb << (const itk::Array<double>&)p.m_CurrentParameters;
+                sb << (const itk::Array<double>&)p.m_CurrentVelocity;
+                sb << p.m_CurrentValue;
+                sb << (const itk::Array<double>&)p.m_BestParameters;
+                sb << p.m_BestValue;
+            }
+        }
+
+        /** Checkpointable method to read the swarm written by saveState(), to be used by the next optimization. */
+        virtual void restoreState( StreamBuffer& sb )
+        {
+            unsigned int nparticles = 0;
+            sb >> this->m_CompletedIterations;
+            sb >> nparticles;
+
+            // each particle takes at least the sizes of its three vectors and its two values, a larger count is not trusted
+            if ( nparticles > (size_t)sb.getSize() / ( 3 * sizeof(unsigned int) + 2 * sizeof(MeasureType) ) )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreState(): invalid number of particles " << nparticles << ", starting over" << End;
+                this->m_CompletedIterations = 0;
+                nparticles = 0;
+            }
+
+            this->m_RestoredParticles.resize( nparticles );
+            for ( unsigned int j = 0; j < nparticles; j++ )
+            {
+                ParticleData& p = this->m_RestoredParticles[j];
+                sb >> (itk::Array<double>&)p.m_CurrentParameters;
+                sb >> (itk::Array<double>&)p.m_CurrentVelocity;
+                sb >> p.m_CurrentValue;
+                sb >> (itk::Array<double>&)p.m_BestParameters;
+                sb >> p.m_BestValue;
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "restoreState(): " << nparticles << " particles restored after " << this->m_CompletedIterations << " iterations" << End;
+        }
+
+        /**
+        Run the optimization. After a restored swarm, only the remaining iterations are run, the maximal
+        number of iterations being lowered for this run only, such that the configured one is kept.
+        */
+        virtual void StartOptimization()
+        {
+            unsigned int maxiter = this->GetMaximalNumberOfIterations();
+            try
+            {
+                Superclass::StartOptimization();
+            }
+            catch (...)
+            {
+                this->SetMaximalNumberOfIterations( maxiter );
+                throw;
+            }
+            this->SetMaximalNumberOfIterations( maxiter );
+        }
+
+    protected:
+        BatchParticleSwarmOptimizer() : m_CompletedIterations(0) {}
+
+        /** Place the initial swarm, and then evaluate all of the particles in one batch. */
+        virtual void Initialize()
+        {
+            CostFunctionType::Pointer costfunc = this->m_CostFunction;
+
+            // let the base class place the particles without evaluating them
+            PlaceholderCostFunction::Pointer placeholder = PlaceholderCostFunction::New();
+            placeholder->setNumberOfParameters( costfunc->GetNumberOfParameters() );
+            this->m_CostFunction = placeholder;
+            try
+            {
+                Superclass::Initialize();
+            }
+            catch (...)
+            {
+                this->m_CostFunction = costfunc;
+                throw;
+            }
+            this->m_CostFunction = costfunc;
+
+            if ( this->restoreSwarm() ) return;
+
+            this->m_CompletedIterations = 0;
+
+            // evaluate the initial swarm
+            this->evaluateSwarm();
+
+            // the best particle of the initial swarm
+            this->m_FunctionBestValue = itk::NumericTraits<MeasureType>::max();
+            for ( unsigned int i = 0; i < this->m_Particles.size(); i++ )
+            {
+                ParticleData& p = this->m_Particles[i];
+                p.m_BestValue = p.m_CurrentValue;
+                p.m_BestParameters = p.m_CurrentParameters;
+                if ( p.m_BestValue < this->m_FunctionBestValue )
+                {
+                    this->m_FunctionBestValue = p.m_BestValue;
+                    this->m_ParametersBestValue = p.m_BestParameters;
+                }
+            }
+            this->SetCurrentPosition( this->m_ParametersBestValue );
+
+            if ( !this->m_FunctionBestValueMemory.empty() )
+            {
+                this->m_FunctionBestValueMemory[0] = this->m_FunctionBestValue;
+            }
+        }
+
+        /** Move all the particles, then evaluate the new positions in one batch. */
+        virtual void UpdateSwarm()
+        {
+            typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+            RandomGeneratorType::Pointer rng = RandomGeneratorType::GetInstance();
+
+            unsigned int n = this->m_CostFunction->GetNumberOfParameters();
+
+            for ( unsigned int j = 0; j < this->m_Particles.size(); j++ )
+            {
+                ParticleData& p = this->m_Particles[j];
+
+                double phi1 = rng->GetVariateWithClosedRange() * this->GetPersonalCoefficient();
+                double phi2 = rng->GetVariateWithClosedRange() * this->GetGlobalCoefficient();
+
+                for ( unsigned int k = 0; k < n; k++ )
+                {
+                    p.m_CurrentVelocity[k] = this->GetInertiaCoefficient() * p.m_CurrentVelocity[k] +
+                                             phi1 * ( p.m_BestParameters[k] - p.m_CurrentParameters[k] ) +
+                                             phi2 * ( this->m_ParametersBestValue[k] - p.m_CurrentParameters[k] );
+                    p.m_CurrentParameters[k] += p.m_CurrentVelocity[k];
+
+                    // keep the particle within the bounds
+                    if ( p.m_CurrentParameters[k] < this->m_ParameterBounds[k].first )
+                    {
+                        p.m_CurrentParameters[k] = this->m_ParameterBounds[k].first;
+                        p.m_CurrentVelocity[k] = 0;
+                    }
+                    else if ( p.m_CurrentParameters[k] > this->m_ParameterBounds[k].second )
+                    {
+                        p.m_CurrentParameters[k] = this->m_ParameterBounds[k].second;
+                        p.m_CurrentVelocity[k] = 0;
+                    }
+                }
+            }
+
+            this->evaluateSwarm();
+
+            for ( unsigned int j = 0; j < this->m_Particles.size(); j++ )
+            {
+                ParticleData& p = this->m_Particles[j];
+                if ( p.m_CurrentValue < p.m_BestValue )
+                {
+                    p.m_BestValue = p.m_CurrentValue;
+                    p.m_BestParameters = p.m_CurrentParameters;
+                }
+            }
+
+            this->m_CompletedIterations++;
+        }
+
+        /**
+        Replace the swarm placed by the base class with the restored one, if any, and compatible with
+        the current settings. Return true if the swarm was restored.
+        */
+        bool restoreSwarm()
+        {
+            if ( this->m_RestoredParticles.empty() ) return false;
+
+            SwarmType particles;
+            particles.swap( this->m_RestoredParticles );
+
+            unsigned int n = this->m_CostFunction->GetNumberOfParameters();
+            if ( particles.size() != this->m_Particles.size() || particles[0].m_CurrentParameters.GetSize() != n )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreSwarm(): restored swarm does not match the settings, starting over" << End;
+                return false;
+            }
+            this->m_Particles = particles;
+
+            this->m_FunctionBestValue = itk::NumericTraits<MeasureType>::max();
+            for ( unsigned int i = 0; i < this->m_Particles.size(); i++ )
+            {
+                const ParticleData& p = this->m_Particles[i];
+                if ( p.m_BestValue < this->m_FunctionBestValue )
+                {
+                    this->m_FunctionBestValue = p.m_BestValue;
+                    this->m_ParametersBestValue = p.m_BestParameters;
+                }
+            }
+            this->SetCurrentPosition( this->m_ParametersBestValue );
+
+            std::fill( this->m_FunctionBestValueMemory.begin(), this->m_FunctionBestValueMemory.end(), this->m_FunctionBestValue );
+
+            // only the remaining iterations are run, see StartOptimization()
+            unsigned int maxiter = this->GetMaximalNumberOfIterations();
+            this->SetMaximalNumberOfIterations( maxiter > this->m_CompletedIterations ? maxiter - this->m_CompletedIterations : 1 );
+
+            return true;
+        }
+
+        /** Compute the values at the current positions of all particles in one batch. */
+        void evaluateSwarm()
+        {
+            unsigned int nparticles = this->m_Particles.size();
+
+            ParametersListType params( nparticles );
+            for ( unsigned int j = 0; j < nparticles; j++ )
+            {
+                params[j] = this->m_Particles[j].m_CurrentParameters;
+            }
+
+            MeasureListType values;
+            GetCostFunctionValues( this->m_CostFunction, params, values );
+
+            for ( unsigned int j = 0; j < nparticles; j++ )
+            {
+                this->m_Particles[j].m_CurrentValue = values[j];
+            }
+        }
+
+    private:
+        BatchParticleSwarmOptimizer( const Self & ); // purposely not implemented
+        BatchParticleSwarmOptimizer& operator=( const Self & ); // purposely not implemented
+
+        unsigned int m_CompletedIterations;
+
+        /** Swarm read by restoreState(), until it replaces the initial swarm. */
+        SwarmType m_RestoredParticles;
+    };
+
+} // namespace szi
+
+#endif // _sziBatchParticleSwarmOptimizer_h_
@@ -0,0 +1,423 @@
+#ifndef _sziBayesianOptimizer_h_
+#define _sziBayesianOptimizer_h_
+
+#include <itkNumericTraits.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_erf.h>
+#include <vnl/vnl_math.h>
+#include <vnl/algo/vnl_cholesky.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "sziBatchCostFunction.h"
+#include "sziBoundedOptimizer.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    /**
+    Bayesian optimizer for expensive cost functions, e.g. SystemTrainingMetric where each value is a whole set of
+    registrations. The cost function is modeled by a Gaussian process (GP) with a squared exponential kernel over the
+    parameter bounds scaled to the unit cube, whose length scale is chosen by maximizing the marginal likelihood.
+    After a Latin hypercube design of initial samples, each iteration proposes a batch of points maximizing the
+    expected improvement (EI) over the best value so far, the points of the batch being made different by assuming
+    ("constant liar") that the points already proposed have the best value; the batch is then evaluated at once, so
+    that a cost function implementing BatchCostFunction keeps several workers busy.
+    An iteration event is invoked after each batch, with the current position set to the best point so far.
+    All the points evaluated so far can be saved to a checkpoint, and the optimization resumed from them.
+    */
+    class BayesianOptimizer : public BoundedOptimizer
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BayesianOptimizer Self;
+        typedef BoundedOptimizer Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BayesianOptimizer, szi::BoundedOptimizer );
+
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+
+        /** Set/get the total number of cost function evaluations, including the initial samples (100 by default). */
+        void setMaximumNumberOfEvaluations( unsigned int n ) { this->m_MaximumNumberOfEvaluations = n; }
+        unsigned int getMaximumNumberOfEvaluations() const { return this->m_MaximumNumberOfEvaluations; }
+
+        /** Set/get the number of initial samples, including the initial position; zero (the default) means 2n+1 for n parameters. */
+        void setNumberOfInitialSamples( unsigned int n ) { this->m_NumberOfInitialSamples = n; }
+        unsigned int getNumberOfInitialSamples() const { return this->m_NumberOfInitialSamples; }
+
+        /** Set/get the number of points proposed and evaluated in one batch (4 by default). */
+        void setBatchSize( unsigned int n ) { this->m_BatchSize = ( n > 0 ? n : 1 ); }
+        unsigned int getBatchSize() const { return this->m_BatchSize; }
+
+        /** Set/get the noise variance of the GP, relative to the variance of the values (1e-4 by default). */
+        void setNoiseVariance( double v ) { this->m_NoiseVariance = v; }
+        double getNoiseVariance() const { return this->m_NoiseVariance; }
+
+        /** Set/get the improvement, relative to the standard deviation of the values, below which EI does not count (0.01 by default). */
+        void setExplorationOffset( double xi ) { this->m_ExplorationOffset = xi; }
+        double getExplorationOffset() const { return this->m_ExplorationOffset; }
+
+        /** Return the best value found and its position. */
+        MeasureType getBestValue() const { return this->m_BestValue; }
+        const ParametersType& getBestPosition() const { return this->m_BestPosition; }
+
+        /** Return the value of the cost function at the best position. */
+        MeasureType GetValue() const { return this->m_BestValue; }
+
+        /** Stop the optimization after the batch being evaluated. */
+        void StopOptimization() { this->m_Stop = true; }
+
+        /** Checkpointable method to write all the points evaluated so far. */
+        virtual void saveState( StreamBuffer& sb ) const
+        {
+            sb << (unsigned long)this->m_Points.size();
+            for ( unsigned long i = 0; i < this->m_Points.size(); i++ )
+            {
+                sb << (const itk::Array<double>&)this->m_Points[i];
+                sb << this->m_Values[i];
+            }
+        }
+
+        /** Checkpointable method to read the points written by saveState(), such that the next optimization continues from them. */
+        virtual void restoreState( StreamBuffer& sb )
+        {
+            unsigned long n = 0;
+            sb >> n;
+            // each point takes at least its size and its value, a larger count is not trusted
+            if ( n > (unsigned long)sb.getSize() / ( sizeof(unsigned int) + sizeof(MeasureType) ) )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreState(): invalid number of evaluations " << n << ", starting over" << End;
+                n = 0;
+            }
+            this->m_Points.resize( n );
+            this->m_Values.resize( n );
+            for ( unsigned long i = 0; i < n; i++ )
+            {
+                sb >> (itk::Array<double>&)this->m_Points[i];
+                sb >> this->m_Values[i];
+            }
+            this->m_Restored = true;
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "restoreState(): resuming after " << n << " evaluations" << End;
+        }
+
+        virtual void StartOptimization()
+        {
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): =====start=====" << End;
+
+            this->InvokeEvent( itk::StartEvent() );
+            this->m_Stop = false;
+
+            const ParametersType& initial = this->GetInitialPosition();
+            unsigned int n = initial.GetSize();
+
+            if ( this->getParameterBounds().size() != n )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "StartOptimization(): parameter bounds do not match the number of parameters" << End;
+            }
+
+            this->initializeGenerator();
+
+            // keep the points of a restored checkpoint of the same problem, or start over
+            if ( this->m_Restored && ( this->m_Points.empty() || this->m_Points[0].GetSize() == n ) )
+            {
+                this->m_Restored = false;
+            }
+            else
+            {
+                if ( this->m_Restored )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "StartOptimization(): restored state does not match the parameters, starting over" << End;
+                }
+                this->m_Restored = false;
+                this->m_Points.clear();
+                this->m_Values.clear();
+            }
+
+            this->m_BestValue = itk::NumericTraits<MeasureType>::max();
+            this->m_BestPosition = initial;
+            for ( unsigned long i = 0; i < this->m_Values.size(); i++ )
+            {
+                this->updateBest( this->m_Points[i], this->m_Values[i] );
+            }
+
+            unsigned int ninitial = ( this->m_NumberOfInitialSamples ? this->m_NumberOfInitialSamples : 2 * n + 1 );
+            if ( ninitial > this->m_MaximumNumberOfEvaluations ) ninitial = this->m_MaximumNumberOfEvaluations;
+
+            // evaluate the initial design, unless restored
+            if ( this->m_Points.size() < ninitial )
+            {
+                ParametersListType params;
+                this->sampleInitialDesign( initial, ninitial - this->m_Points.size(), params );
+                this->evaluateBatch( params );
+            }
+
+            // then the batches maximizing the expected improvement
+            while ( !this->m_Stop && this->m_Points.size() < this->m_MaximumNumberOfEvaluations )
+            {
+                unsigned int count = std::min( (unsigned long)this->m_BatchSize, (unsigned long)( this->m_MaximumNumberOfEvaluations - this->m_Points.size() ) );
+
+                ParametersListType params;
+                this->proposeBatch( count, params );
+                this->evaluateBatch( params );
+            }
+
+            this->InvokeEvent( itk::EndEvent() );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): -----e-n-d-----" << End;
+        }
+
+    protected:
+        BayesianOptimizer() : m_MaximumNumberOfEvaluations(100), m_NumberOfInitialSamples(0), m_BatchSize(4),
+                              m_NoiseVariance(1e-4), m_ExplorationOffset(0.01),
+                              m_BestValue(0), m_Stop(false), m_Restored(false), m_LengthScale(0.2) {}
+
+        /** Evaluate a batch of points, remember them, and report the best point so far. */
+        void evaluateBatch( const ParametersListType& params )
+        {
+            if ( params.empty() ) return;
+
+            MeasureListType values;
+            GetCostFunctionValues( this->m_CostFunction, params, values );
+
+            for ( unsigned int i = 0; i < params.size(); i++ )
+            {
+                this->m_Points.push_back( params[i] );
+                this->m_Values.push_back( values[i] );
+                this->updateBest( params[i], values[i] );
+            }
+
+            this->SetCurrentPosition( this->m_BestPosition );
+            this->InvokeEvent( itk::IterationEvent() );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "evaluateBatch(): " << this->m_Points.size() << " of " << this->m_MaximumNumberOfEvaluations << " evaluations, best value = " << this->m_BestValue << End;
+        }
+
+        void updateBest( const ParametersType& position, MeasureType value )
+        {
+            if ( value < this->m_BestValue )
+            {
+                this->m_BestValue = value;
+                this->m_BestPosition = position;
+            }
+        }
+
+        /** Sample a Latin hypercube design of points within the bounds, the first one being the initial position if none has been evaluated. */
+        void sampleInitialDesign( const ParametersType& initial, unsigned int count, ParametersListType& params )
+        {
+            unsigned int n = initial.GetSize();
+
+            params.assign( count, ParametersType( n ) );
+            for ( unsigned int k = 0; k < n; k++ )
+            {
+                // one point in each of the count strata of this parameter, in random order
+                std::vector<unsigned int> strata( count );
+                for ( unsigned int i = 0; i < count; i++ ) strata[i] = i;
+                for ( unsigned int i = count; i > 1; i-- )
+                {
+                    std::swap( strata[i-1], strata[ this->getGenerator()->GetIntegerVariate( i - 1 ) ] );
+                }
+
+                for ( unsigned int i = 0; i < count; i++ )
+                {
+                    double u = ( strata[i] + this->getGenerator()->GetVariateWithOpenRange() ) / count;
+                    params[i][k] = this->fromUnit( k, u );
+                }
+            }
+
+            if ( this->m_Points.empty() && count > 0 )
+            {
+                params[0] = initial;
+            }
+        }
+
+        /** Propose a batch of points maximizing the expected improvement, with constant liar for the points already proposed. */
+        void proposeBatch( unsigned int count, ParametersListType& params )
+        {
+            unsigned int n = this->GetInitialPosition().GetSize();
+
+            // observations scaled to the unit cube, with values normalized to zero mean and unit variance
+            std::vector< vnl_vector<double> > xs( this->m_Points.size() );
+            for ( unsigned int i = 0; i < xs.size(); i++ )
+            {
+                xs[i] = this->toUnit( this->m_Points[i] );
+            }
+
+            double mean = 0;
+            for ( unsigned int i = 0; i < this->m_Values.size(); i++ ) mean += this->m_Values[i];
+            mean /= this->m_Values.size();
+            double var = 0;
+            for ( unsigned int i = 0; i < this->m_Values.size(); i++ ) var += ( this->m_Values[i] - mean ) * ( this->m_Values[i] - mean );
+            double sd = std::sqrt( var / this->m_Values.size() );
+            if ( sd < 1e-12 ) sd = 1;
+
+            std::vector<double> ys( this->m_Values.size() );
+            for ( unsigned int i = 0; i < ys.size(); i++ )
+            {
+                ys[i] = ( this->m_Values[i] - mean ) / sd;
+            }
+            double ybest = ( this->m_BestValue - mean ) / sd;
+
+            this->fitLengthScale( xs, ys );
+
+            params.clear();
+            for ( unsigned int b = 0; b < count; b++ )
+            {
+                vnl_matrix<double> K;
+                this->computeCovariance( xs, K );
+                vnl_cholesky chol( K, vnl_cholesky::quiet );
+                vnl_vector<double> alpha = chol.solve( vnl_vector<double>( &ys[0], ys.size() ) );
+
+                vnl_vector<double> x = this->maximizeExpectedImprovement( xs, chol, alpha, ybest, n );
+
+                params.push_back( this->fromUnit( x ) );
+
+                // pretend the point has the best value, such that the next point of the batch goes elsewhere
+                xs.push_back( x );
+                ys.push_back( ybest );
+            }
+        }
+
+        /** Return the point of the unit cube with the highest expected improvement among random candidates and local perturbations of the best points. */
+        vnl_vector<double> maximizeExpectedImprovement( const std::vector< vnl_vector<double> >& xs, const vnl_cholesky& chol,
+                                                        const vnl_vector<double>& alpha, double ybest, unsigned int n )
+        {
+            unsigned int ncandidates = 200 * n + 500;
+
+            vnl_vector<double> best( n );
+            double bestei = -1;
+            for ( unsigned int c = 0; c < ncandidates; c++ )
+            {
+                vnl_vector<double> x( n );
+                if ( c % 2 == 0 || xs.empty() )
+                {
+                    for ( unsigned int k = 0; k < n; k++ ) x[k] = this->getGenerator()->GetVariateWithClosedRange();
+                }
+                else
+                {
+                    // perturb the best point found so far, or the best candidate
+                    const vnl_vector<double>& center = ( bestei > 0 && c % 4 == 1 ? best : this->toUnit( this->m_BestPosition ) );
+                    for ( unsigned int k = 0; k < n; k++ )
+                    {
+                        double u = center[k] + this->getGenerator()->GetNormalVariate( 0, this->m_LengthScale * this->m_LengthScale * 0.25 );
+                        x[k] = ( u < 0 ? 0 : ( u > 1 ? 1 : u ) );
+                    }
+                }
+
+                double ei = this->computeExpectedImprovement( x, xs, chol, alpha, ybest );
+                if ( ei > bestei )
+                {
+                    bestei = ei;
+                    best = x;
+                }
+            }
+            return best;
+        }
+
+        /** Expected improvement of a point below the best (normalized) value, minus the exploration offset. */
+        double computeExpectedImprovement( const vnl_vector<double>& x, const std::vector< vnl_vector<double> >& xs,
+                                           const vnl_cholesky& chol, const vnl_vector<double>& alpha, double ybest ) const
+        {
+            vnl_vector<double> k( xs.size() );
+            for ( unsigned int i = 0; i < xs.size(); i++ ) k[i] = this->kernel( x, xs[i] );
+
+            double mu = dot_product( k, alpha );
+            double var = 1.0 - dot_product( k, chol.solve( k ) );
+            if ( var < 1e-12 ) return 0;
+            double sigma = std::sqrt( var );
+
+            double improvement = ybest - mu - this->m_ExplorationOffset;
+            double z = improvement / sigma;
+            double cdf = 0.5 * vnl_erfc( -z / std::sqrt( 2.0 ) );
+            double pdf = std::exp( -0.5 * z * z ) / std::sqrt( 2.0 * vnl_math::pi );
+            return improvement * cdf + sigma * pdf;
+        }
+
+        /** Choose the length scale of the kernel maximizing the marginal likelihood of the observations. */
+        void fitLengthScale( const std::vector< vnl_vector<double> >& xs, const std::vector<double>& ys )
+        {
+            static const double scales[] = { 0.05, 0.1, 0.2, 0.3, 0.5, 0.8, 1.2 };
+
+            vnl_vector<double> y( &ys[0], ys.size() );
+            double bestll = -itk::NumericTraits<double>::max();
+            double best = this->m_LengthScale;
+            for ( unsigned int s = 0; s < sizeof(scales) / sizeof(scales[0]); s++ )
+            {
+                this->m_LengthScale = scales[s];
+
+                vnl_matrix<double> K;
+                this->computeCovariance( xs, K );
+                vnl_cholesky chol( K, vnl_cholesky::quiet );
+                if ( chol.rank_deficiency() ) continue;
+
+                vnl_matrix<double> L = chol.lower_triangle();
+                double logdet = 0;
+                for ( unsigned int i = 0; i < L.rows(); i++ ) logdet += 2 * std::log( L( i, i ) );
+
+                double ll = -0.5 * dot_product( y, chol.solve( y ) ) - 0.5 * logdet;
+                if ( ll > bestll )
+                {
+                    bestll = ll;
+                    best = scales[s];
+                }
+            }
+            this->m_LengthScale = best;
+        }
+
+        void computeCovariance( const std::vector< vnl_vector<double> >& xs, vnl_matrix<double>& K ) const
+        {
+            K.set_size( xs.size(), xs.size() );
+            for ( unsigned int i = 0; i < xs.size(); i++ )
+            {
+                for ( unsigned int j = 0; j <= i; j++ )
+                {
+                    K( i, j ) = K( j, i ) = this->kernel( xs[i], xs[j] );
+                }
+                K( i, i ) += this->m_NoiseVariance;
+            }
+        }
+
+        double kernel( const vnl_vector<double>& a, const vnl_vector<double>& b ) const
+        {
+            return std::exp( -0.5 * vnl_vector_ssd( a, b ) / ( this->m_LengthScale * this->m_LengthScale ) );
+        }
+
+    private:
+        BayesianOptimizer( const Self & ); // purposely not implemented
+        BayesianOptimizer& operator=( const Self & ); // purposely not implemented
+
+        unsigned int m_MaximumNumberOfEvaluations;
+        unsigned int m_NumberOfInitialSamples;
+        unsigned int m_BatchSize;
+        double m_NoiseVariance;
+        double m_ExplorationOffset;
+
+        /** Points evaluated so far, and their values. */
+        ParametersListType m_Points;
+        MeasureListType m_Values;
+
+        MeasureType m_BestValue;
+        ParametersType m_BestPosition;
+
+        bool m_Stop;
+        bool m_Restored;
+
+        double m_LengthScale;
+    };
+
+} // namespace szi
+
+#endif // _sziBayesianOptimizer_h_
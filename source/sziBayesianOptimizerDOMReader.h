@@ -0,0 +1,115 @@
+#ifndef _sziBayesianOptimizerDOMReader_h_
+#define _sziBayesianOptimizerDOMReader_h_
+
+#include "sziBoundedOptimizerDOMReader.h"
+#include "sziBayesianOptimizer.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    class BayesianOptimizerDOMReader : public BoundedOptimizerDOMReader<BayesianOptimizer>
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BayesianOptimizerDOMReader Self;
+        typedef BoundedOptimizerDOMReader<BayesianOptimizer> Superclass;
+        typedef itk::SmartPointer<Self> Pointer;
+        typedef itk::SmartPointer<const Self> ConstPointer;
+
+        /** Method for creation through the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BayesianOptimizerDOMReader, szi::BoundedOptimizerDOMReader );
+
+        typedef Superclass::OutputType OutputType;
+        typedef Superclass::DOMNodeType DOMNodeType;
+
+    protected:
+        BayesianOptimizerDOMReader() {}
+
+        virtual void GenerateData( const DOMNodeType* inputdom, const void* )
+        {
+        	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): =====start=====" << End;
+
+            itk::FancyString tagname = inputdom->GetName();
+
+            if ( tagname != "BayesianOptimizer" )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Input DOM object is invalid!" << End;
+            }
+
+            OutputType* output = this->GetOutput();
+            if ( output == NULL )
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Creating a new output Bayesian optimizer object ..." << End;
+                OutputType::Pointer object = OutputType::New();
+                output = (OutputType*)object;
+                this->SetOutput( output );
+            }
+            else
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Filling an existing output Bayesian optimizer object ..." << End;
+            }
+
+            itk::FancyString s;
+
+            s = inputdom->GetAttribute("MaximumNumberOfEvaluations");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setMaximumNumberOfEvaluations( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): MaximumNumberOfEvaluations = " << n << End;
+            }
+            else
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): MaximumNumberOfEvaluations not provided!" << End;
+            }
+
+            s = inputdom->GetAttribute("NumberOfInitialSamples");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setNumberOfInitialSamples( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): NumberOfInitialSamples = " << n << End;
+            }
+
+            s = inputdom->GetAttribute("BatchSize");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setBatchSize( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): BatchSize = " << output->getBatchSize() << End;
+            }
+
+            s = inputdom->GetAttribute("NoiseVariance");
+            if ( s != "" )
+            {
+                double v = 0; s >> v;
+                output->setNoiseVariance( v );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): NoiseVariance = " << v << End;
+            }
+
+            s = inputdom->GetAttribute("ExplorationOffset");
+            if ( s != "" )
+            {
+                double xi = 0; s >> xi;
+                output->setExplorationOffset( xi );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ExplorationOffset = " << xi << End;
+            }
+
+            // read the parameter bounds and the seed
+            this->readBoundedOptimizer( inputdom, output );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): -----e-n-d-----" << End;
+        }
+
+    private:
+        BayesianOptimizerDOMReader( const Self & ); // purposely not implemented
+        BayesianOptimizerDOMReader& operator=( const Self & ); // purposely not implemented
+    };
+
+} // namespace szi
+
+#endif // _sziBayesianOptimizerDOMReader_h_
@@ -0,0 +1,99 @@
+#ifndef _sziBoundedOptimizer_h_
+#define _sziBoundedOptimizer_h_
+
+#include <itkSingleValuedNonLinearOptimizer.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <vnl/vnl_vector.h>
+
+#include <utility>
+#include <vector>
+
+#include "sziCheckpointable.h"
+
+namespace szi
+{
+
+    /**
+    Base class of the optimizers that sample the box given by lower and upper bounds of each parameter,
+    e.g. BayesianOptimizer and CMAESOptimizer. It holds the bounds and the random generator, and maps
+    the parameters to and from the unit cube over the bounds, in which the subclasses work.
+    */
+    class BoundedOptimizer : public itk::SingleValuedNonLinearOptimizer, public Checkpointable
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BoundedOptimizer Self;
+        typedef itk::SingleValuedNonLinearOptimizer Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BoundedOptimizer, SingleValuedNonLinearOptimizer );
+
+        /** Lower and upper bounds of each parameter, as for itk::ParticleSwarmOptimizer. */
+        typedef std::vector< std::pair<double,double> > ParameterBoundsType;
+
+        void setParameterBounds( const ParameterBoundsType& bounds ) { this->m_ParameterBounds = bounds; }
+        const ParameterBoundsType& getParameterBounds() const { return this->m_ParameterBounds; }
+
+        /** Set the seed of the random sampling, for repeatable results. */
+        void setSeed( unsigned int seed ) { this->m_Seed = seed; this->m_UseSeed = true; }
+
+    protected:
+        BoundedOptimizer() : m_Seed(0), m_UseSeed(false) {}
+
+        typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+        /** Create the random generator, seeded if a seed was set; called when an optimization starts. */
+        void initializeGenerator()
+        {
+            this->m_Generator = GeneratorType::New();
+            if ( this->m_UseSeed )
+            {
+                this->m_Generator->Initialize( this->m_Seed );
+            }
+        }
+
+        GeneratorType* getGenerator() const { return this->m_Generator; }
+
+        double fromUnit( unsigned int k, double u ) const
+        {
+            const std::pair<double,double>& bound = this->m_ParameterBounds[k];
+            return bound.first + u * ( bound.second - bound.first );
+        }
+
+        ParametersType fromUnit( const vnl_vector<double>& x ) const
+        {
+            ParametersType p( x.size() );
+            for ( unsigned int k = 0; k < x.size(); k++ ) p[k] = this->fromUnit( k, x[k] );
+            return p;
+        }
+
+        vnl_vector<double> toUnit( const ParametersType& p ) const
+        {
+            vnl_vector<double> x( p.GetSize() );
+            for ( unsigned int k = 0; k < p.GetSize(); k++ )
+            {
+                const std::pair<double,double>& bound = this->m_ParameterBounds[k];
+                double range = bound.second - bound.first;
+                x[k] = ( range > 0 ? ( p[k] - bound.first ) / range : 0.5 );
+            }
+            return x;
+        }
+
+    private:
+        BoundedOptimizer( const Self & ); // purposely not implemented
+        BoundedOptimizer& operator=( const Self & ); // purposely not implemented
+
+        ParameterBoundsType m_ParameterBounds;
+
+        unsigned int m_Seed;
+        bool m_UseSeed;
+
+        GeneratorType::Pointer m_Generator;
+    };
+
+} // namespace szi
+
+#endif // _sziBoundedOptimizer_h_
@@ -0,0 +1,90 @@
+#ifndef _sziBoundedOptimizerDOMReader_h_
+#define _sziBoundedOptimizerDOMReader_h_
+
+#include <itkDOMReader.h>
+
+#include "sziBoundedOptimizer.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    /**
+    Base class of the DOM readers of the optimizers derived from BoundedOptimizer, reading the settings
+    they share: the "lbound" and "ubound" children, and the "SamplingSeed" attribute.
+    */
+    template < typename TOutput >
+    class BoundedOptimizerDOMReader : public itk::DOMReader<TOutput>
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef BoundedOptimizerDOMReader Self;
+        typedef itk::DOMReader<TOutput> Superclass;
+        typedef itk::SmartPointer<Self> Pointer;
+        typedef itk::SmartPointer<const Self> ConstPointer;
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::BoundedOptimizerDOMReader, DOMReader );
+
+        typedef typename Superclass::OutputType OutputType;
+        typedef typename Superclass::DOMNodeType DOMNodeType;
+
+    protected:
+        BoundedOptimizerDOMReader() {}
+
+        /** Read the settings of BoundedOptimizer from the DOM object of the optimizer. */
+        void readBoundedOptimizer( const DOMNodeType* inputdom, BoundedOptimizer* output )
+        {
+            itk::FancyString s;
+
+            const DOMNodeType* node = 0;
+
+            s = inputdom->GetAttribute( "SamplingSeed" );
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setSeed( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): SamplingSeed = " << n << End;
+            }
+
+            // read the lower bound of the search domain
+            node = inputdom->GetChildByID( "lbound" );
+            s = node ? node->GetAttribute("value") : "";
+            if ( s == "" )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Lower bound of the parameters is missing!" << End;
+            }
+            std::vector<double> lbound;
+            s.ToData( lbound );
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): lbound = " << lbound << End;
+            // get the upper bound of the search domain
+            node = inputdom->GetChildByID( "ubound" );
+            s = node ? node->GetAttribute("value") : "";
+            if ( s == "" )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Upper bound of the parameters is missing!" << End;
+            }
+            std::vector<double> ubound;
+            s.ToData( ubound );
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ubound = " << ubound << End;
+            // combine the two
+            if ( lbound.size() != ubound.size() )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Sizes of lower and upper parameters bounds mismatch!" << End;
+            }
+            BoundedOptimizer::ParameterBoundsType bounds;
+            for ( size_t i = 0; i < lbound.size(); i++ )
+            {
+                bounds.push_back( std::pair<double,double>( lbound[i], ubound[i] ) );
+            }
+            output->setParameterBounds( bounds );
+        }
+
+    private:
+        BoundedOptimizerDOMReader( const Self & ); // purposely not implemented
+        BoundedOptimizerDOMReader& operator=( const Self & ); // purposely not implemented
+    };
+
+} // namespace szi
+
+#endif // _sziBoundedOptimizerDOMReader_h_
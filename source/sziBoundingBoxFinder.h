@@ -3,7 +3,11 @@
 
 #include <itkObject.h>
 #include <itkImage.h>
-#include <itkImageRegionIteratorWithIndex.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkImageRegionSplitter.h>
+#include <itkMultiThreader.h>
+
+#include <vector>
 
 namespace szi
 {
@@ -42,6 +46,14 @@ namespace szi
             _value = value;
         }
 
+        /**
+        Set the number of threads scanning the rows of the image, by default the global default of ITK.
+        */
+        void setNumberOfThreads( unsigned int n )
+        {
+            _nthreads = ( n ? n : 1 );
+        }
+
         void update()
         {
             _output = OutputType();
@@ -49,39 +61,49 @@ namespace szi
             //
             _input->Update();
             //
+            // scan the rows of the image over several threads, each finding the bounding box of its split
+            typedef itk::ImageRegionSplitter<ImageType::ImageDimension> SplitterType;
+            typename SplitterType::Pointer splitter = SplitterType::New();
+            _nsplits = splitter->GetNumberOfSplits( _input->GetBufferedRegion(), _nthreads );
+            _found.assign( _nsplits, false );
+            _minIndices.resize( _nsplits );
+            _maxIndices.resize( _nsplits );
+            //
+            itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+            threader->SetNumberOfThreads( _nsplits );
+            threader->SetSingleMethod( thread_callback, (void*)this );
+            threader->SingleMethodExecute();
+            //
+            // merge the bounding boxes of the splits
             typedef typename ImageType::IndexType IndexType;
             IndexType minIndex;
             IndexType maxIndex;
             //
             bool first_time = true;
             //
-            typedef itk::ImageRegionIteratorWithIndex<ImageType> IteratorType;
-            IteratorType it( _input, _input->GetBufferedRegion() );
-            for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+            for ( unsigned int t=0; t<_nsplits; t++ )
             {
-                if ( it.Get() != _value ) continue;
+                if ( !_found[t] ) continue;
                 //
-                IndexType idx = it.GetIndex();
                 if ( first_time )
                 {
-                    minIndex = idx;
-                    maxIndex = idx;
+                    minIndex = _minIndices[t];
+                    maxIndex = _maxIndices[t];
                     first_time = false;
                 }
                 else
                 {
                     for ( int i=0; i<ImageType::ImageDimension; i++ )
                     {
-                        if ( minIndex[i] > idx[i] ) minIndex[i] = idx[i];
-                    }
-                    //
-                    for ( int i=0; i<ImageType::ImageDimension; i++ )
-                    {
-                        if ( maxIndex[i] < idx[i] ) maxIndex[i] = idx[i];
+                        if ( minIndex[i] > _minIndices[t][i] ) minIndex[i] = _minIndices[t][i];
+                        if ( maxIndex[i] < _maxIndices[t][i] ) maxIndex[i] = _maxIndices[t][i];
                     }
                 }
             }
             //
+            // no pixel has the label value
+            if ( first_time ) return;
+            //
             _output.SetIndex( minIndex );
             //
             typedef typename ImageType::SizeType SizeType;
@@ -101,7 +123,69 @@ namespace szi
         }
 
     protected:
-        BoundingBoxFinder() : _value() {}
+        BoundingBoxFinder() : _value(), _nsplits(0)
+        {
+            _nthreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+        }
+
+        static ITK_THREAD_RETURN_TYPE thread_callback( void* arg )
+        {
+            typedef itk::MultiThreader::ThreadInfoStruct ThreaderInfoType;
+            ThreaderInfoType* tinfo = (ThreaderInfoType*)arg;
+
+            Self* self = (Self*)( tinfo->UserData );
+            if ( tinfo->ThreadID < self->_nsplits )
+            {
+                typedef itk::ImageRegionSplitter<ImageType::ImageDimension> SplitterType;
+                typename SplitterType::Pointer splitter = SplitterType::New();
+                self->scan( tinfo->ThreadID, splitter->GetSplit( tinfo->ThreadID, self->_nsplits, self->_input->GetBufferedRegion() ) );
+            }
+
+            return ITK_THREAD_RETURN_VALUE;
+        }
+
+        /** Find the bounding box of a split of the image, looking for the first and last labeled pixels of each row. */
+        void scan( unsigned int t, const RegionType& region )
+        {
+            typedef typename ImageType::IndexType IndexType;
+            IndexType& minIndex = _minIndices[t];
+            IndexType& maxIndex = _maxIndices[t];
+            //
+            const long width = region.GetSize( 0 );
+            //
+            typedef itk::ImageLinearConstIteratorWithIndex<ImageType> IteratorType;
+            IteratorType it( _input, region );
+            it.SetDirection( 0 );
+            for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+            {
+                IndexType idx = it.GetIndex();
+                const PixelType* row = &_input->GetPixel( idx );
+                //
+                long first = 0;
+                while ( first < width && row[first] != _value ) first++;
+                if ( first == width ) continue;
+                long last = width - 1;
+                while ( row[last] != _value ) last--;
+                //
+                if ( !_found[t] )
+                {
+                    minIndex = idx;
+                    maxIndex = idx;
+                    minIndex[0] += first;
+                    maxIndex[0] += last;
+                    _found[t] = true;
+                    continue;
+                }
+                //
+                for ( int i=1; i<ImageType::ImageDimension; i++ )
+                {
+                    if ( minIndex[i] > idx[i] ) minIndex[i] = idx[i];
+                    if ( maxIndex[i] < idx[i] ) maxIndex[i] = idx[i];
+                }
+                if ( minIndex[0] > idx[0] + first ) minIndex[0] = idx[0] + first;
+                if ( maxIndex[0] < idx[0] + last ) maxIndex[0] = idx[0] + last;
+            }
+        }
 
     private:
         BoundingBoxFinder( const Self & ); // purposely not implemented
@@ -109,8 +193,15 @@ namespace szi
 
         typename InputType::Pointer _input;
         PixelType _value;
+        unsigned int _nthreads;
         //
         OutputType _output;
+        //
+        // per-split results of the scan
+        unsigned int _nsplits;
+        std::vector<char> _found;
+        std::vector<typename ImageType::IndexType> _minIndices;
+        std::vector<typename ImageType::IndexType> _maxIndices;
     };
 
 } // namespace szi
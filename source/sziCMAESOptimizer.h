@@ -0,0 +1,402 @@
+#ifndef _sziCMAESOptimizer_h_
+#define _sziCMAESOptimizer_h_
+
+#include <itkNumericTraits.h>
+#include <itkArray.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "sziBatchCostFunction.h"
+#include "sziBoundedOptimizer.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    /**
+    Covariance matrix adaptation evolution strategy (CMA-ES) optimizer. Each generation samples a population of points
+    from a multivariate normal distribution over the parameter bounds scaled to the unit cube, and evaluates it at once,
+    such that a cost function implementing BatchCostFunction keeps several workers busy; the mean, step size and
+    covariance of the distribution are then adapted towards the best half of the population. A point outside the bounds
+    is evaluated at its nearest point on them, but the distribution is adapted with the original point, ranked with a
+    penalty growing with its squared distance to the bounds, such that the mean is drawn back inside them without
+    biasing the covariance and step size towards the bounds. When a run has converged, the optimizer restarts from a
+    random mean with a population twice as large (IPOP-CMA-ES), up to the number of restarts set. An iteration event is
+    invoked after each generation, with the current position set to the best point so far.
+    */
+    class CMAESOptimizer : public BoundedOptimizer
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef CMAESOptimizer Self;
+        typedef BoundedOptimizer Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::CMAESOptimizer, szi::BoundedOptimizer );
+
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+
+        /** Set/get the population size of the first run; zero (the default) means 4+3ln(n) for n parameters. */
+        void setPopulationSize( unsigned int n ) { this->m_PopulationSize = n; }
+        unsigned int getPopulationSize() const { return this->m_PopulationSize; }
+
+        /** Set/get the initial step size, relative to the parameter bounds (0.3 by default). */
+        void setInitialStepSize( double sigma ) { this->m_InitialStepSize = sigma; }
+        double getInitialStepSize() const { return this->m_InitialStepSize; }
+
+        /** Set/get the total number of generations over all runs (100 by default). */
+        void setMaximumNumberOfGenerations( unsigned int n ) { this->m_MaximumNumberOfGenerations = n; }
+        unsigned int getMaximumNumberOfGenerations() const { return this->m_MaximumNumberOfGenerations; }
+
+        /** Set/get the number of restarts with a doubled population after a run has converged (2 by default). */
+        void setNumberOfRestarts( unsigned int n ) { this->m_NumberOfRestarts = n; }
+        unsigned int getNumberOfRestarts() const { return this->m_NumberOfRestarts; }
+
+        /** Set/get the range of the best values over recent generations below which a run has converged (1e-6 by default). */
+        void setFunctionConvergenceTolerance( double tol ) { this->m_FunctionConvergenceTolerance = tol; }
+        double getFunctionConvergenceTolerance() const { return this->m_FunctionConvergenceTolerance; }
+
+        /** Set/get the step size, relative to the parameter bounds, below which a run has converged (1e-4 by default). */
+        void setParametersConvergenceTolerance( double tol ) { this->m_ParametersConvergenceTolerance = tol; }
+        double getParametersConvergenceTolerance() const { return this->m_ParametersConvergenceTolerance; }
+
+        /** Return the best value found and its position. */
+        MeasureType getBestValue() const { return this->m_BestValue; }
+        const ParametersType& getBestPosition() const { return this->m_BestPosition; }
+
+        /** Return the value of the cost function at the best position. */
+        MeasureType GetValue() const { return this->m_BestValue; }
+
+        /** Stop the optimization after the generation being evaluated. */
+        void StopOptimization() { this->m_Stop = true; }
+
+        /** Checkpointable method to write the distribution of the current run, and the best point so far. */
+        virtual void saveState( StreamBuffer& sb ) const
+        {
+            sb << this->m_Restart;
+            sb << this->m_Lambda;
+            sb << this->m_Generation;
+            sb << this->m_TotalGenerations;
+            sb << this->m_Sigma;
+            this->writeVector( sb, this->m_Mean );
+            this->writeVector( sb, this->m_PathC );
+            this->writeVector( sb, this->m_PathSigma );
+            this->writeVector( sb, vnl_vector<double>( this->m_C.data_block(), this->m_C.size() ) );
+            sb << this->m_BestValue;
+            sb << (const itk::Array<double>&)this->m_BestPosition;
+        }
+
+        /** Checkpointable method to read the state written by saveState(), such that the next optimization continues the run. */
+        virtual void restoreState( StreamBuffer& sb )
+        {
+            sb >> this->m_Restart;
+            sb >> this->m_Lambda;
+            sb >> this->m_Generation;
+            sb >> this->m_TotalGenerations;
+            sb >> this->m_Sigma;
+            this->readVector( sb, this->m_Mean );
+            this->readVector( sb, this->m_PathC );
+            this->readVector( sb, this->m_PathSigma );
+            vnl_vector<double> c;
+            this->readVector( sb, c );
+            this->m_C.set_size( this->m_Mean.size(), this->m_Mean.size() );
+            if ( c.size() == this->m_C.size() ) this->m_C.copy_in( c.data_block() );
+            sb >> this->m_BestValue;
+            sb >> (itk::Array<double>&)this->m_BestPosition;
+            this->m_Restored = true;
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "restoreState(): resuming run " << this->m_Restart << " at generation " << this->m_TotalGenerations << End;
+        }
+
+        virtual void StartOptimization()
+        {
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): =====start=====" << End;
+
+            this->InvokeEvent( itk::StartEvent() );
+            this->m_Stop = false;
+
+            const ParametersType& initial = this->GetInitialPosition();
+            unsigned int n = initial.GetSize();
+
+            if ( this->getParameterBounds().size() != n )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "StartOptimization(): parameter bounds do not match the number of parameters" << End;
+            }
+
+            this->initializeGenerator();
+
+            // continue the run of a restored checkpoint of the same problem, or start over
+            if ( this->m_Restored && this->m_Mean.size() == n && this->m_BestPosition.GetSize() == n )
+            {
+                this->m_Restored = false;
+                this->setStrategyParameters();
+                this->m_History.clear();
+            }
+            else
+            {
+                if ( this->m_Restored )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "StartOptimization(): restored state does not match the parameters, starting over" << End;
+                }
+                this->m_Restored = false;
+                this->m_Restart = 0;
+                this->m_TotalGenerations = 0;
+                this->m_BestValue = itk::NumericTraits<MeasureType>::max();
+                this->m_BestPosition = initial;
+                this->m_Lambda = ( this->m_PopulationSize ? this->m_PopulationSize : 4 + (unsigned int)( 3 * std::log( (double)n ) ) );
+                this->startRun( this->toUnit( initial ) );
+            }
+
+            while ( !this->m_Stop && this->m_TotalGenerations < this->m_MaximumNumberOfGenerations )
+            {
+                if ( this->runGeneration() )
+                {
+                    if ( this->m_Restart >= this->m_NumberOfRestarts ) break;
+
+                    // IPOP: start over from a random mean with a doubled population
+                    this->m_Restart++;
+                    this->m_Lambda *= 2;
+
+                    vnl_vector<double> mean( n );
+                    for ( unsigned int k = 0; k < n; k++ ) mean[k] = this->getGenerator()->GetVariateWithClosedRange();
+                    this->startRun( mean );
+
+                    getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): restart " << this->m_Restart << " with population size " << this->m_Lambda << End;
+                }
+            }
+
+            this->InvokeEvent( itk::EndEvent() );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "StartOptimization(): -----e-n-d-----" << End;
+        }
+
+    protected:
+        CMAESOptimizer() : m_PopulationSize(0), m_InitialStepSize(0.3), m_MaximumNumberOfGenerations(100), m_NumberOfRestarts(2),
+                           m_FunctionConvergenceTolerance(1e-6), m_ParametersConvergenceTolerance(1e-4),
+                           m_BestValue(0), m_Stop(false), m_Restored(false), m_Restart(0), m_Lambda(0), m_Generation(0), m_TotalGenerations(0),
+                           m_Sigma(0), m_Mu(0), m_MuEff(0), m_CC(0), m_CS(0), m_C1(0), m_CMu(0), m_DampS(0), m_ChiN(0) {}
+
+        /** Start a run with the current population size from a mean in the unit cube. */
+        void startRun( const vnl_vector<double>& mean )
+        {
+            unsigned int n = mean.size();
+
+            this->m_Mean = mean;
+            this->m_Sigma = this->m_InitialStepSize;
+            this->m_C.set_size( n, n );
+            this->m_C.set_identity();
+            this->m_PathC.set_size( n );
+            this->m_PathC.fill( 0 );
+            this->m_PathSigma.set_size( n );
+            this->m_PathSigma.fill( 0 );
+            this->m_Generation = 0;
+            this->m_History.clear();
+
+            this->setStrategyParameters();
+        }
+
+        /** Compute the recombination weights and learning rates for the current population size. */
+        void setStrategyParameters()
+        {
+            double n = this->m_Mean.size();
+
+            this->m_Mu = std::max( 1u, this->m_Lambda / 2 );
+            this->m_Weights.set_size( this->m_Mu );
+            for ( unsigned int i = 0; i < this->m_Mu; i++ )
+            {
+                this->m_Weights[i] = std::log( this->m_Mu + 0.5 ) - std::log( i + 1.0 );
+            }
+            this->m_Weights /= this->m_Weights.sum();
+            this->m_MuEff = 1.0 / this->m_Weights.squared_magnitude();
+
+            this->m_CC = ( 4 + this->m_MuEff / n ) / ( n + 4 + 2 * this->m_MuEff / n );
+            this->m_CS = ( this->m_MuEff + 2 ) / ( n + this->m_MuEff + 5 );
+            this->m_C1 = 2 / ( ( n + 1.3 ) * ( n + 1.3 ) + this->m_MuEff );
+            this->m_CMu = std::min( 1 - this->m_C1, 2 * ( this->m_MuEff - 2 + 1 / this->m_MuEff ) / ( ( n + 2 ) * ( n + 2 ) + this->m_MuEff ) );
+            this->m_DampS = 1 + 2 * std::max( 0.0, std::sqrt( ( this->m_MuEff - 1 ) / ( n + 1 ) ) - 1 ) + this->m_CS;
+            this->m_ChiN = std::sqrt( n ) * ( 1 - 1 / ( 4 * n ) + 1 / ( 21 * n * n ) );
+        }
+
+        /** Sample, evaluate and select one generation, and adapt the distribution; return true if the run has converged. */
+        bool runGeneration()
+        {
+            unsigned int n = this->m_Mean.size();
+
+            // C = B diag(D^2) B'
+            vnl_symmetric_eigensystem<double> eig( this->m_C );
+            vnl_vector<double> D( n );
+            for ( unsigned int k = 0; k < n; k++ ) D[k] = std::sqrt( std::max( eig.D( k, k ), 0.0 ) );
+            const vnl_matrix<double>& B = eig.V;
+
+            // sample the population, and evaluate the points outside the unit cube at their nearest point on it
+            std::vector< vnl_vector<double> > xs( this->m_Lambda );
+            std::vector<double> distances( this->m_Lambda );
+            ParametersListType params( this->m_Lambda );
+            for ( unsigned int i = 0; i < this->m_Lambda; i++ )
+            {
+                vnl_vector<double> z( n );
+                for ( unsigned int k = 0; k < n; k++ ) z[k] = D[k] * this->getGenerator()->GetNormalVariate();
+                xs[i] = this->m_Mean + this->m_Sigma * ( B * z );
+
+                vnl_vector<double> repaired = xs[i];
+                for ( unsigned int k = 0; k < n; k++ ) repaired[k] = std::min( 1.0, std::max( 0.0, xs[i][k] ) );
+                distances[i] = ( xs[i] - repaired ).squared_magnitude();
+                params[i] = this->fromUnit( repaired );
+            }
+
+            MeasureListType values;
+            GetCostFunctionValues( this->m_CostFunction, params, values );
+
+            unsigned int best = 0;
+            MeasureType worst = values[0];
+            for ( unsigned int i = 1; i < this->m_Lambda; i++ )
+            {
+                if ( values[i] < values[best] ) best = i;
+                if ( values[i] > worst ) worst = values[i];
+            }
+
+            if ( values[best] < this->m_BestValue )
+            {
+                this->m_BestValue = values[best];
+                this->m_BestPosition = params[best];
+            }
+
+            // rank the original points, penalizing the squared distance to the bounds (relative to the step size)
+            // with the spread of the values, such that a point one step outside ranks after the points inside
+            double penalty = ( worst > values[best] ? worst - values[best] : 1.0 ) / ( this->m_Sigma * this->m_Sigma );
+            std::vector< std::pair<MeasureType,unsigned int> > ranks( this->m_Lambda );
+            for ( unsigned int i = 0; i < this->m_Lambda; i++ )
+            {
+                ranks[i] = std::make_pair( values[i] + penalty * distances[i], i );
+            }
+            std::sort( ranks.begin(), ranks.end() );
+
+            // recombination
+            vnl_vector<double> old = this->m_Mean;
+            this->m_Mean.fill( 0 );
+            for ( unsigned int i = 0; i < this->m_Mu; i++ )
+            {
+                this->m_Mean += this->m_Weights[i] * xs[ ranks[i].second ];
+            }
+            vnl_vector<double> ymean = ( this->m_Mean - old ) / this->m_Sigma;
+
+            // evolution paths, with C^-1/2 = B diag(1/D) B'
+            vnl_vector<double> w = B.transpose() * ymean;
+            for ( unsigned int k = 0; k < n; k++ ) w[k] /= std::max( D[k], 1e-300 );
+            this->m_PathSigma = ( 1 - this->m_CS ) * this->m_PathSigma + std::sqrt( this->m_CS * ( 2 - this->m_CS ) * this->m_MuEff ) * ( B * w );
+
+            double norm = this->m_PathSigma.magnitude();
+            bool hsig = norm / std::sqrt( 1 - std::pow( 1 - this->m_CS, 2.0 * ( this->m_Generation + 1 ) ) ) / this->m_ChiN < 1.4 + 2.0 / ( n + 1 );
+            this->m_PathC = ( 1 - this->m_CC ) * this->m_PathC;
+            if ( hsig ) this->m_PathC += std::sqrt( this->m_CC * ( 2 - this->m_CC ) * this->m_MuEff ) * ymean;
+
+            // covariance matrix: rank-one and rank-mu updates
+            vnl_matrix<double> C = ( 1 - this->m_C1 - this->m_CMu ) * this->m_C + this->m_C1 * outer_product( this->m_PathC, this->m_PathC );
+            if ( !hsig ) C += ( this->m_C1 * this->m_CC * ( 2 - this->m_CC ) ) * this->m_C;
+            for ( unsigned int i = 0; i < this->m_Mu; i++ )
+            {
+                vnl_vector<double> y = ( xs[ ranks[i].second ] - old ) / this->m_Sigma;
+                C += ( this->m_CMu * this->m_Weights[i] ) * outer_product( y, y );
+            }
+            this->m_C = ( C + C.transpose() ) * 0.5;
+
+            // step size
+            this->m_Sigma *= std::exp( ( this->m_CS / this->m_DampS ) * ( norm / this->m_ChiN - 1 ) );
+
+            this->m_Generation++;
+            this->m_TotalGenerations++;
+
+            this->SetCurrentPosition( this->m_BestPosition );
+            this->InvokeEvent( itk::IterationEvent() );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "runGeneration(): generation " << this->m_TotalGenerations << ", step size = " << this->m_Sigma << ", best value = " << this->m_BestValue << End;
+
+            // convergence: flat best values over recent generations, tiny steps, or degenerate covariance
+            this->m_History.push_back( values[best] );
+            unsigned int span = 10 + (unsigned int)std::ceil( 30.0 * n / this->m_Lambda );
+            if ( this->m_History.size() > span ) this->m_History.pop_front();
+
+            if ( this->m_History.size() == span )
+            {
+                double range = *std::max_element( this->m_History.begin(), this->m_History.end() ) - *std::min_element( this->m_History.begin(), this->m_History.end() );
+                if ( range < this->m_FunctionConvergenceTolerance ) return true;
+            }
+            if ( this->m_Sigma * D.max_value() < this->m_ParametersConvergenceTolerance ) return true;
+            if ( D.min_value() <= 0 || D.max_value() / D.min_value() > 1e7 ) return true;
+
+            return false;
+        }
+
+        void writeVector( StreamBuffer& sb, const vnl_vector<double>& v ) const
+        {
+            itk::Array<double> a( v.size() );
+            for ( unsigned int k = 0; k < v.size(); k++ ) a[k] = v[k];
+            sb << a;
+        }
+
+        void readVector( StreamBuffer& sb, vnl_vector<double>& v ) const
+        {
+            itk::Array<double> a;
+            sb >> a;
+            v.set_size( a.GetSize() );
+            for ( unsigned int k = 0; k < a.GetSize(); k++ ) v[k] = a[k];
+        }
+
+    private:
+        CMAESOptimizer( const Self & ); // purposely not implemented
+        CMAESOptimizer& operator=( const Self & ); // purposely not implemented
+
+        unsigned int m_PopulationSize;
+        double m_InitialStepSize;
+        unsigned int m_MaximumNumberOfGenerations;
+        unsigned int m_NumberOfRestarts;
+        double m_FunctionConvergenceTolerance;
+        double m_ParametersConvergenceTolerance;
+
+        MeasureType m_BestValue;
+        ParametersType m_BestPosition;
+
+        bool m_Stop;
+        bool m_Restored;
+
+        /** State of the current run, in the unit cube. */
+        unsigned int m_Restart;
+        unsigned int m_Lambda;
+        unsigned int m_Generation;
+        unsigned int m_TotalGenerations;
+        double m_Sigma;
+        vnl_vector<double> m_Mean;
+        vnl_matrix<double> m_C;
+        vnl_vector<double> m_PathC;
+        vnl_vector<double> m_PathSigma;
+        std::deque<MeasureType> m_History;
+
+        /** Strategy parameters derived from the population size. */
+        unsigned int m_Mu;
+        vnl_vector<double> m_Weights;
+        double m_MuEff;
+        double m_CC;
+        double m_CS;
+        double m_C1;
+        double m_CMu;
+        double m_DampS;
+        double m_ChiN;
+    };
+
+} // namespace szi
+
+#endif // _sziCMAESOptimizer_h_
@@ -0,0 +1,123 @@
+#ifndef _sziCMAESOptimizerDOMReader_h_
+#define _sziCMAESOptimizerDOMReader_h_
+
+#include "sziBoundedOptimizerDOMReader.h"
+#include "sziCMAESOptimizer.h"
+#include "sziLogService.h"
+
+namespace szi
+{
+
+    class CMAESOptimizerDOMReader : public BoundedOptimizerDOMReader<CMAESOptimizer>
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef CMAESOptimizerDOMReader Self;
+        typedef BoundedOptimizerDOMReader<CMAESOptimizer> Superclass;
+        typedef itk::SmartPointer<Self> Pointer;
+        typedef itk::SmartPointer<const Self> ConstPointer;
+
+        /** Method for creation through the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::CMAESOptimizerDOMReader, szi::BoundedOptimizerDOMReader );
+
+        typedef Superclass::OutputType OutputType;
+        typedef Superclass::DOMNodeType DOMNodeType;
+
+    protected:
+        CMAESOptimizerDOMReader() {}
+
+        virtual void GenerateData( const DOMNodeType* inputdom, const void* )
+        {
+        	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): =====start=====" << End;
+
+            itk::FancyString tagname = inputdom->GetName();
+
+            if ( tagname != "CMAESOptimizer" )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Input DOM object is invalid!" << End;
+            }
+
+            OutputType* output = this->GetOutput();
+            if ( output == NULL )
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Creating a new output CMA-ES optimizer object ..." << End;
+                OutputType::Pointer object = OutputType::New();
+                output = (OutputType*)object;
+                this->SetOutput( output );
+            }
+            else
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Filling an existing output CMA-ES optimizer object ..." << End;
+            }
+
+            itk::FancyString s;
+
+            s = inputdom->GetAttribute("PopulationSize");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setPopulationSize( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): PopulationSize = " << n << End;
+            }
+
+            s = inputdom->GetAttribute("InitialStepSize");
+            if ( s != "" )
+            {
+                double sigma = 0; s >> sigma;
+                output->setInitialStepSize( sigma );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): InitialStepSize = " << sigma << End;
+            }
+
+            s = inputdom->GetAttribute("MaximumNumberOfGenerations");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setMaximumNumberOfGenerations( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): MaximumNumberOfGenerations = " << n << End;
+            }
+            else
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): MaximumNumberOfGenerations not provided!" << End;
+            }
+
+            s = inputdom->GetAttribute("NumberOfRestarts");
+            if ( s != "" )
+            {
+                unsigned int n = 0; s >> n;
+                output->setNumberOfRestarts( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): NumberOfRestarts = " << n << End;
+            }
+
+            s = inputdom->GetAttribute("FunctionConvergenceTolerance");
+            if ( s != "" )
+            {
+                double ftol = 0; s >> ftol;
+                output->setFunctionConvergenceTolerance( ftol );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): FunctionConvergenceTolerance = " << ftol << End;
+            }
+
+            s = inputdom->GetAttribute("ParametersConvergenceTolerance");
+            if ( s != "" )
+            {
+                double ptol = 0; s >> ptol;
+                output->setParametersConvergenceTolerance( ptol );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ParametersConvergenceTolerance = " << ptol << End;
+            }
+
+            // read the parameter bounds and the seed
+            this->readBoundedOptimizer( inputdom, output );
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): -----e-n-d-----" << End;
+        }
+
+    private:
+        CMAESOptimizerDOMReader( const Self & ); // purposely not implemented
+        CMAESOptimizerDOMReader& operator=( const Self & ); // purposely not implemented
+    };
+
+} // namespace szi
+
+#endif // _sziCMAESOptimizerDOMReader_h_
@@ -0,0 +1,60 @@
+#ifndef _sziCancellationToken_h_
+#define _sziCancellationToken_h_
+
+#include <itkObject.h>
+
+namespace szi
+{
+
+    /**
+    Class to tell a long computation, e.g. a registration, that its result is no longer needed, such that
+    it can stop at the next opportunity. The computation checks isCancelled() regularly; subclasses may
+    override poll() to find out about cancellation requests from elsewhere, e.g. messages from a master.
+    */
+    class CancellationToken : public itk::Object
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef CancellationToken Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::CancellationToken, Object );
+
+        /** Request the computation to stop. */
+        void cancel() { this->m_Cancelled = true; }
+
+        /** Clear the cancellation request, before starting a new computation. */
+        void reset() { this->m_Cancelled = false; }
+
+        /** Return true if the computation has been requested to stop. */
+        bool isCancelled()
+        {
+            if ( !this->m_Cancelled && this->poll() )
+            {
+                this->m_Cancelled = true;
+            }
+            return this->m_Cancelled;
+        }
+
+    protected:
+        CancellationToken() : m_Cancelled(false) {}
+
+        /** Return true if a cancellation request has arrived since the last call; none by default. */
+        virtual bool poll() { return false; }
+
+    private:
+        CancellationToken( const Self & ); // purposely not implemented
+        CancellationToken& operator=( const Self & ); // purposely not implemented
+
+        bool m_Cancelled;
+    };
+
+} // namespace szi
+
+#endif // _sziCancellationToken_h_
@@ -0,0 +1,30 @@
+#ifndef _sziCheckpointable_h_
+#define _sziCheckpointable_h_
+
+#include "sziStreamable.h"
+
+namespace szi
+{
+
+    /**
+    Abstract class (interface) to represent any object whose progress can be saved to a checkpoint,
+    and restored from it by a later run, such that a long computation can be resumed after a failure.
+    */
+    class Checkpointable
+    {
+    public:
+        /** Abstract method to write the state needed to resume the computation. */
+        virtual void saveState( StreamBuffer& sb ) const = 0;
+
+        /**
+        Abstract method to read the state written by saveState(). The computation started next
+        continues from this state rather than from the beginning.
+        */
+        virtual void restoreState( StreamBuffer& sb ) = 0;
+
+        virtual ~Checkpointable() {}
+    };
+
+} // namespace szi
+
+#endif // _sziCheckpointable_h_
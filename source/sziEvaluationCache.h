@@ -0,0 +1,270 @@
+#ifndef _sziEvaluationCache_h_
+#define _sziEvaluationCache_h_
+
+#include <itkObject.h>
+#include <itkIntTypes.h>
+
+#include "sziSystemData.h"
+#include "sziCheckpointable.h"
+#include "sziLogService.h"
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace szi
+{
+
+    /**
+    Class to remember the performance scores computed for (training example, parameters) pairs, such
+    that identical or nearly identical evaluations are not computed again. The parameters are quantized
+    with a fixed step before lookup, and the training examples are identified by a fingerprint of their
+    content, which remains valid across runs. Optionally, the scores are appended to a file as they are
+    inserted, and read back when the file is loaded, such that repeated or resumed jobs reuse them.
+    */
+    class EvaluationCache : public itk::Object, public Checkpointable
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef EvaluationCache Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::EvaluationCache, Object );
+
+        typedef SystemData DataType;
+        typedef DataType::ParametersType ParametersType;
+        typedef DataType::MeasureType MeasureType;
+
+        typedef itk::uint64_t FingerprintType;
+
+        /** Set/get the quantization step of the parameters: parameters closer than this share their scores. */
+        void setQuantizationStep( double step ) { this->m_QuantizationStep = step; }
+        double getQuantizationStep() const { return this->m_QuantizationStep; }
+
+        /** Set/get the file the scores are persisted to, or an empty name to keep them in memory only. */
+        void setFileName( const std::string& fn ) { this->m_FileName = fn; }
+        const std::string& getFileName() const { return this->m_FileName; }
+
+        unsigned long getNumberOfHits() const { return this->m_NumberOfHits; }
+        unsigned long getNumberOfMisses() const { return this->m_NumberOfMisses; }
+        unsigned long getNumberOfEntries() const { return this->m_Entries.size(); }
+
+        /**
+        Return the fingerprint of a training example, i.e. a hash of its streamed content excluding the
+        parameters, the score and the fields used for communication. Only full-fidelity scores are cached.
+        */
+        FingerprintType getFingerprint( const DataType* data )
+        {
+            FingerprintMap::const_iterator i = this->m_Fingerprints.find( data );
+            if ( i != this->m_Fingerprints.end() ) return i->second;
+
+            DataType::Pointer copy = data->clone();
+            copy->m_Parameters.SetSize( 0 );
+            copy->m_Score = 0;
+            copy->m_Rank = -1;
+            copy->m_OpId = -1;
+            copy->m_ExampleId = -1;
+            copy->m_Fidelity = 1;
+
+            StreamBuffer sb;
+            sb << (const Streamable&)(*copy);
+
+            // 64-bit FNV-1a
+            FingerprintType h = 14695981039346656037ULL;
+            const unsigned char* p = (const unsigned char*)sb.getPointer();
+            for ( long k = 0; k < sb.getSize(); k++ )
+            {
+                h ^= p[k];
+                h *= 1099511628211ULL;
+            }
+
+            this->m_Fingerprints[data] = h;
+            return h;
+        }
+
+        /** Look up the score of a training example under a setting of the parameters; return false if unknown. */
+        bool find( const DataType* data, const ParametersType& params, MeasureType& value )
+        {
+            EntryMap::const_iterator i = this->m_Entries.find( this->makeKey( this->getFingerprint( data ), params ) );
+            if ( i == this->m_Entries.end() )
+            {
+                this->m_NumberOfMisses++;
+                return false;
+            }
+
+            this->m_NumberOfHits++;
+            value = i->second;
+            return true;
+        }
+
+        /** Remember the score of a training example under a setting of the parameters, and persist it. */
+        void insert( const DataType* data, const ParametersType& params, MeasureType value )
+        {
+            FingerprintType fp = this->getFingerprint( data );
+            this->m_Entries[ this->makeKey( fp, params ) ] = value;
+
+            if ( this->m_FileName.empty() ) return;
+
+            if ( !this->m_FileStream.is_open() )
+            {
+                this->m_FileStream.open( this->m_FileName.c_str(), std::ios::out | std::ios::app );
+                if ( !this->m_FileStream )
+                {
+                    getSystemLogger() << StartWarning(this->GetNameOfClass()) << "insert(): cannot write to \"" << this->m_FileName << "\", scores are kept in memory only" << End;
+                    this->m_FileName = "";
+                    return;
+                }
+                this->m_FileStream.precision( 17 );
+            }
+
+            // one line per score, flushed right away such that an interrupted job loses nothing
+            this->m_FileStream << fp << " " << value << " " << params.GetSize();
+            for ( unsigned int k = 0; k < params.GetSize(); k++ )
+            {
+                this->m_FileStream << " " << params[k];
+            }
+            this->m_FileStream << std::endl;
+        }
+
+        /** Read the scores persisted to the file by previous runs, if any. */
+        void load()
+        {
+            if ( this->m_FileName.empty() ) return;
+
+            std::ifstream ifs( this->m_FileName.c_str() );
+            if ( !ifs ) return;
+
+            unsigned long n = 0;
+            std::string line;
+            while ( std::getline( ifs, line ) )
+            {
+                std::istringstream iss( line );
+                FingerprintType fp = 0;
+                MeasureType value = 0;
+                unsigned int size = 0;
+                if ( !( iss >> fp >> value >> size ) ) continue;
+
+                ParametersType params( size );
+                for ( unsigned int k = 0; k < size && iss; k++ )
+                {
+                    iss >> params[k];
+                }
+                if ( !iss ) continue;
+
+                this->m_Entries[ this->makeKey( fp, params ) ] = value;
+                n++;
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "load(): " << n << " scores read from \"" << this->m_FileName << "\"" << End;
+        }
+
+        /** Checkpointable method to write all the scores, such that a resumed job does not compute them again. */
+        virtual void saveState( StreamBuffer& sb ) const
+        {
+            sb << this->m_QuantizationStep;
+            sb << (unsigned long)this->m_Entries.size();
+            for ( EntryMap::const_iterator i = this->m_Entries.begin(); i != this->m_Entries.end(); i++ )
+            {
+                const KeyType& key = i->first;
+                sb << key.first;
+                sb << (unsigned int)key.second.size();
+                for ( unsigned int k = 0; k < key.second.size(); k++ )
+                {
+                    sb << key.second[k];
+                }
+                sb << i->second;
+            }
+        }
+
+        /** Checkpointable method to read the scores written by saveState(). */
+        virtual void restoreState( StreamBuffer& sb )
+        {
+            double step = 0;
+            unsigned long n = 0;
+            sb >> step;
+            sb >> n;
+
+            // the keys are only valid with the same quantization step
+            bool valid = ( step == this->m_QuantizationStep );
+            for ( unsigned long j = 0; j < n; j++ )
+            {
+                KeyType key;
+                unsigned int size = 0;
+                MeasureType value = 0;
+                sb >> key.first;
+                sb >> size;
+                // a key longer than the data left is not trusted, nor are the following scores
+                if ( (size_t)sb.getSize() < size * sizeof(double) + sizeof(MeasureType) )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreState(): scores truncated after " << j << " of " << n << End;
+                    break;
+                }
+                key.second.resize( size );
+                for ( unsigned int k = 0; k < size; k++ )
+                {
+                    sb >> key.second[k];
+                }
+                sb >> value;
+                if ( valid ) this->m_Entries[key] = value;
+            }
+
+            if ( !valid )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreState(): quantization step has changed, " << n << " scores discarded" << End;
+            }
+        }
+
+        /** Write the usage statistics to the log. */
+        void report( const char* caller ) const
+        {
+            unsigned long total = this->m_NumberOfHits + this->m_NumberOfMisses;
+            double rate = ( total ? 100.0 * this->m_NumberOfHits / total : 0.0 );
+            getSystemLogger() << StartInfo(caller) << "EvaluationCache: " << this->m_NumberOfHits << " hits, " << this->m_NumberOfMisses << " misses (" << rate << "% hit rate), " << this->m_Entries.size() << " scores" << End;
+        }
+
+    protected:
+        EvaluationCache() : m_QuantizationStep(1e-6), m_NumberOfHits(0), m_NumberOfMisses(0) {}
+
+        typedef std::pair< FingerprintType, std::vector<double> > KeyType;
+
+        KeyType makeKey( FingerprintType fp, const ParametersType& params ) const
+        {
+            KeyType key( fp, std::vector<double>( params.GetSize() ) );
+            for ( unsigned int k = 0; k < params.GetSize(); k++ )
+            {
+                key.second[k] = ( this->m_QuantizationStep > 0 ? std::floor( params[k] / this->m_QuantizationStep + 0.5 ) : params[k] );
+            }
+            return key;
+        }
+
+    private:
+        EvaluationCache( const Self & ); // purposely not implemented
+        EvaluationCache& operator=( const Self & ); // purposely not implemented
+
+        typedef std::map<KeyType,MeasureType> EntryMap;
+        EntryMap m_Entries;
+
+        typedef std::map<const DataType*,FingerprintType> FingerprintMap;
+        FingerprintMap m_Fingerprints;
+
+        double m_QuantizationStep;
+
+        std::string m_FileName;
+        std::ofstream m_FileStream;
+
+        unsigned long m_NumberOfHits;
+        unsigned long m_NumberOfMisses;
+    };
+
+} // namespace szi
+
+#endif // _sziEvaluationCache_h_
@@ -1,14 +1,11 @@
 #ifndef _sziExampleRegistrater1_h_
 #define _sziExampleRegistrater1_h_
 
-#include <itkImageRegistrationMethod.h>
-#include "sziTunable.h"
+#include "sziTunableRegistrationMethod.h"
 
 #include <itkMatrixOffsetTransformBase.h>
 #include <itkSimilarity3DTransform.h>
 
-#include <itkRegularStepGradientDescentOptimizer.h>
-
 #include "sziLogService.h"
 
 namespace szi
@@ -24,12 +21,12 @@ namespace szi
     failure rate, computation speed, and so on.
     */
     template < typename TFixedImage, typename TMovingImage >
-    class ExampleRegistrater1 : public itk::ImageRegistrationMethod<TFixedImage,TMovingImage>, public Tunable
+    class ExampleRegistrater1 : public TunableRegistrationMethod<TFixedImage,TMovingImage>
     {
     public:
         /** Standard class typedefs. */
         typedef ExampleRegistrater1 Self;
-        typedef itk::ImageRegistrationMethod<TFixedImage,TMovingImage> Superclass;
+        typedef TunableRegistrationMethod<TFixedImage,TMovingImage> Superclass;
         typedef itk::SmartPointer< Self > Pointer;
         typedef itk::SmartPointer< const Self > ConstPointer;
 
@@ -37,7 +34,7 @@ namespace szi
         itkFactorylessNewMacro( Self );
 
         /** Run-time type information (and related methods). */
-        itkTypeMacro( szi::ExampleRegistrater1, ImageRegistrationMethod );
+        itkTypeMacro( szi::ExampleRegistrater1, szi::TunableRegistrationMethod );
 
         static const unsigned int SpaceDimension = TFixedImage::ImageDimension;
 
@@ -50,9 +47,11 @@ namespace szi
         typedef typename Superclass::TransformType SuperTransformType;
         typedef itk::Similarity3DTransform<double> TransformType;
 
-        typedef itk::RegularStepGradientDescentOptimizer OptimizerType;
+        typedef typename Superclass::OptimizerType OptimizerType;
         typedef typename OptimizerType::ScalesType ScalesType;
 
+        typedef typename Superclass::MetricType MetricType;
+
         virtual void setTunableParameters( const ParametersType& params )
         {
             Tunable::setTunableParameters( params );
@@ -96,8 +95,28 @@ namespace szi
 
         	double initialStepLength = optimizer->GetMaximumStepLength();
 
-            // perform registration
-            this->Update();
+            // at a lower fidelity, perform fewer iterations with fewer samples
+            unsigned long iterations = optimizer->GetNumberOfIterations();
+            optimizer->SetNumberOfIterations( this->getReducedCount( iterations ) );
+            unsigned long samples = this->reduceSamples( this->GetMetric() );
+
+            // perform registration, stopping at the next iteration once the score is no longer needed
+            unsigned long observer = this->observeCancellation( optimizer );
+            try
+            {
+                this->Update();
+            }
+            catch (...)
+            {
+                optimizer->RemoveObserver( observer );
+                optimizer->SetNumberOfIterations( iterations );
+                this->restoreSamples( this->GetMetric(), samples );
+                throw;
+            }
+            optimizer->RemoveObserver( observer );
+
+            optimizer->SetNumberOfIterations( iterations );
+            this->restoreSamples( this->GetMetric(), samples );
 
             optimizer->SetMaximumStepLength( initialStepLength );
 
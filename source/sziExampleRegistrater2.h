@@ -1,16 +1,13 @@
 #ifndef _sziExampleRegistrater2_h_
 #define _sziExampleRegistrater2_h_
 
-#include <itkImageRegistrationMethod.h>
-#include "sziTunable.h"
+#include "sziTunableRegistrationMethod.h"
 
 #include <itkMatrixOffsetTransformBase.h>
 #include <itkSimilarity3DTransform.h>
 #include <itkBSplineDeformableTransform.h>
 #include "sziBSplineDeformableTransformInitializer.h"
 
-#include <itkRegularStepGradientDescentOptimizer.h>
-
 #include <vector>
 
 #include "sziLogService.h"
@@ -27,12 +24,12 @@ namespace szi
     FFD registration is an expensive operation and users want to obtain the best result with the least computation time.
     */
     template < typename TFixedImage, typename TMovingImage >
-    class ExampleRegistrater2 : public itk::ImageRegistrationMethod<TFixedImage,TMovingImage>, public Tunable
+    class ExampleRegistrater2 : public TunableRegistrationMethod<TFixedImage,TMovingImage>
     {
     public:
         /** Standard class typedefs. */
         typedef ExampleRegistrater2 Self;
-        typedef itk::ImageRegistrationMethod<TFixedImage,TMovingImage> Superclass;
+        typedef TunableRegistrationMethod<TFixedImage,TMovingImage> Superclass;
         typedef itk::SmartPointer< Self > Pointer;
         typedef itk::SmartPointer< const Self > ConstPointer;
 
@@ -40,7 +37,7 @@ namespace szi
         itkFactorylessNewMacro( Self );
 
         /** Run-time type information (and related methods). */
-        itkTypeMacro( szi::ExampleRegistrater2, ImageRegistrationMethod );
+        itkTypeMacro( szi::ExampleRegistrater2, szi::TunableRegistrationMethod );
 
         typedef TFixedImage FixedImageType;
         typedef TMovingImage MovingImageType;
@@ -56,12 +53,14 @@ namespace szi
 
         typedef typename Superclass::TransformType TransformType;
 
-        typedef itk::RegularStepGradientDescentOptimizer OptimizerType;
+        typedef typename Superclass::OptimizerType OptimizerType;
         typedef typename OptimizerType::ScalesType ScalesType;
 
-        typedef Superclass RegistraterType;
+        typedef itk::ImageRegistrationMethod<TFixedImage,TMovingImage> RegistraterType;
         typedef typename RegistraterType::Pointer RegistraterPointer;
 
+        typedef typename Superclass::MetricType MetricType;
+
         void setRegistrater( RegistraterType* registrater, int level )
         {
         	if ( level >0 && level <= 2 )
@@ -138,8 +137,29 @@ namespace szi
 
         virtual void updatePerformanceScore()
         {
-            // perform registration
-            this->Update();
+            OptimizerType* optimizer = dynamic_cast<OptimizerType*>( this->GetOptimizer() );
+
+            // at a lower fidelity, use fewer samples at both levels (the iterations are reduced by Update())
+            unsigned long samples1 = this->reduceSamples( this->m_Registraters[0]->GetMetric() );
+            unsigned long samples2 = this->reduceSamples( this->m_Registraters[1]->GetMetric() );
+
+            // perform registration, stopping at the next iteration once the score is no longer needed
+            unsigned long observer = this->observeCancellation( optimizer );
+            try
+            {
+                this->Update();
+            }
+            catch (...)
+            {
+                optimizer->RemoveObserver( observer );
+                this->restoreSamples( this->m_Registraters[0]->GetMetric(), samples1 );
+                this->restoreSamples( this->m_Registraters[1]->GetMetric(), samples2 );
+                throw;
+            }
+            optimizer->RemoveObserver( observer );
+
+            this->restoreSamples( this->m_Registraters[0]->GetMetric(), samples1 );
+            this->restoreSamples( this->m_Registraters[1]->GetMetric(), samples2 );
         }
 
         virtual void Update()
@@ -167,7 +187,7 @@ namespace szi
             OptimizerType* optimizer1 = dynamic_cast<OptimizerType*>( registrater->GetOptimizer() );
             optimizer->SetMaximumStepLength( optimizer1->GetMaximumStepLength() );
             optimizer->SetMinimumStepLength( optimizer1->GetMinimumStepLength() );
-            optimizer->SetNumberOfIterations( optimizer1->GetNumberOfIterations() );
+            optimizer->SetNumberOfIterations( this->getReducedCount( optimizer1->GetNumberOfIterations() ) );
             optimizer->SetGradientMagnitudeTolerance( optimizer1->GetGradientMagnitudeTolerance() );
             optimizer->SetRelaxationFactor( optimizer1->GetRelaxationFactor() );
             //
@@ -177,7 +197,9 @@ namespace szi
 
         	this->GetTransform()->SetParameters( this->GetLastTransformParameters() );
 
-            // perform the fine-level registration
+            // perform the fine-level registration, unless the score is no longer needed
+
+        	if ( this->isCancelled() ) return;
 
         	optimizer->InvokeEvent( ProgressEvent() );
 
@@ -210,7 +232,7 @@ namespace szi
             OptimizerType* optimizer2 = dynamic_cast<OptimizerType*>( registrater->GetOptimizer() );
             optimizer->SetMaximumStepLength( optimizer2->GetMaximumStepLength() );
             optimizer->SetMinimumStepLength( optimizer2->GetMinimumStepLength() );
-            optimizer->SetNumberOfIterations( optimizer2->GetNumberOfIterations() );
+            optimizer->SetNumberOfIterations( this->getReducedCount( optimizer2->GetNumberOfIterations() ) );
             optimizer->SetGradientMagnitudeTolerance( optimizer2->GetGradientMagnitudeTolerance() );
             optimizer->SetRelaxationFactor( optimizer2->GetRelaxationFactor() );
             //
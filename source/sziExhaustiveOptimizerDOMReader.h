@@ -4,6 +4,8 @@
 #include <itkExhaustiveOptimizer.h>
 #include <itkDOMReader.h>
 
+#include "sziBatchExhaustiveOptimizer.h"
+
 #include "sziLogService.h"
 
 namespace szi
@@ -32,8 +34,17 @@ namespace szi
         {
         	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): =====start=====" << End;
 
+            itk::FancyString tagname = inputdom->GetName();
+
             OutputType* output = this->GetOutput();
-            if ( output == NULL )
+            if ( output == NULL && tagname == "BatchExhaustiveOptimizer" )
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): creating the batch output object ..." << End;
+                BatchExhaustiveOptimizer::Pointer object = BatchExhaustiveOptimizer::New();
+                output = (BatchExhaustiveOptimizer*)object;
+                this->SetOutput( output );
+            }
+            else if ( output == NULL )
             {
             	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): creating the output object ..." << End;
                 OutputType::Pointer object = OutputType::New();
@@ -45,8 +56,7 @@ namespace szi
             	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): filling an existing output object ..." << End;
             }
 
-            itk::FancyString objname = output->GetNameOfClass();
-            if ( objname != inputdom->GetName() )
+            if ( tagname != "ExhaustiveOptimizer" && tagname != "BatchExhaustiveOptimizer" )
             {
             	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): invalid input DOM object" << End;
             }
@@ -92,6 +102,23 @@ namespace szi
             	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): Scales not provided!" << End;
             }
 
+            BatchExhaustiveOptimizer* batch = dynamic_cast<BatchExhaustiveOptimizer*>( output );
+            s = inputdom->GetAttribute("BatchSize");
+            if ( batch && s != "" )
+            {
+                unsigned int value = 0;
+                s >> value;
+                batch->setBatchSize( value );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): BatchSize = " << value << End;
+            }
+
+            s = inputdom->GetAttribute("ResultsFileName");
+            if ( batch && s != "" )
+            {
+                batch->setResultsFileName( s );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ResultsFileName = " << s << End;
+            }
+
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): -----e-n-d-----" << End;
         }
 
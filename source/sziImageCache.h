@@ -0,0 +1,157 @@
+#ifndef _sziImageCache_h_
+#define _sziImageCache_h_
+
+#include <itkObject.h>
+#include <itkDataObject.h>
+
+#include "sziLogService.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace szi
+{
+
+    /**
+    Class to keep data objects (e.g. images that have been read and cropped) in memory, keyed by
+    a string that identifies how they were produced. The total size of the cached objects is bounded;
+    when a new object does not fit, the least recently used objects are evicted first.
+    */
+    class ImageCache : public itk::Object
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef ImageCache Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::ImageCache, Object );
+
+        typedef std::string KeyType;
+        typedef unsigned long SizeType;
+
+        /** Set/get the maximum total size (in bytes) of the cached objects. Zero disables the cache. */
+        void setMaximumSize( SizeType size )
+        {
+            this->m_MaximumSize = size;
+            this->evict( 0 );
+        }
+        SizeType getMaximumSize() const { return this->m_MaximumSize; }
+
+        /** Return the current total size (in bytes) of the cached objects. */
+        SizeType getSize() const { return this->m_Size; }
+
+        unsigned long getNumberOfHits() const { return this->m_NumberOfHits; }
+        unsigned long getNumberOfMisses() const { return this->m_NumberOfMisses; }
+        unsigned long getNumberOfEvictions() const { return this->m_NumberOfEvictions; }
+
+        /** Return the object cached under the key, or null if there is none. */
+        itk::DataObject* find( const KeyType& key )
+        {
+            EntryMap::iterator i = this->m_Entries.find( key );
+            if ( i == this->m_Entries.end() )
+            {
+                this->m_NumberOfMisses++;
+                return 0;
+            }
+
+            // move the entry to the front of the usage list
+            this->m_UsageList.splice( this->m_UsageList.begin(), this->m_UsageList, i->second.m_Usage );
+
+            this->m_NumberOfHits++;
+            return i->second.m_Object;
+        }
+
+        /** Cache an object of the given size under the key, evicting the least recently used objects as needed. */
+        void insert( const KeyType& key, itk::DataObject* object, SizeType size )
+        {
+            this->erase( key );
+
+            if ( object == 0 || size > this->m_MaximumSize ) return;
+
+            this->evict( size );
+
+            this->m_UsageList.push_front( key );
+
+            Entry& entry = this->m_Entries[key];
+            entry.m_Object = object;
+            entry.m_Size = size;
+            entry.m_Usage = this->m_UsageList.begin();
+
+            this->m_Size += size;
+        }
+
+        /** Remove the object cached under the key, if any. */
+        void erase( const KeyType& key )
+        {
+            EntryMap::iterator i = this->m_Entries.find( key );
+            if ( i == this->m_Entries.end() ) return;
+
+            this->m_Size -= i->second.m_Size;
+            this->m_UsageList.erase( i->second.m_Usage );
+            this->m_Entries.erase( i );
+        }
+
+        /** Remove all cached objects. */
+        void clear()
+        {
+            this->m_Entries.clear();
+            this->m_UsageList.clear();
+            this->m_Size = 0;
+        }
+
+        /** Write the usage statistics to the log. */
+        void report( const char* caller ) const
+        {
+            getSystemLogger() << StartInfo(caller) << "ImageCache: " << this->m_NumberOfHits << " hits, " << this->m_NumberOfMisses << " misses, " << this->m_NumberOfEvictions << " evictions, " << this->m_Entries.size() << " objects, " << ( this->m_Size >> 20 ) << " of " << ( this->m_MaximumSize >> 20 ) << " MB" << End;
+        }
+
+    protected:
+        ImageCache() : m_MaximumSize(0), m_Size(0), m_NumberOfHits(0), m_NumberOfMisses(0), m_NumberOfEvictions(0) {}
+
+        /** Evict the least recently used objects until an object of the given size fits. */
+        void evict( SizeType size )
+        {
+            while ( !this->m_UsageList.empty() && this->m_Size + size > this->m_MaximumSize )
+            {
+                KeyType key = this->m_UsageList.back();
+                this->erase( key );
+                this->m_NumberOfEvictions++;
+            }
+        }
+
+    private:
+        ImageCache( const Self & ); // purposely not implemented
+        ImageCache& operator=( const Self & ); // purposely not implemented
+
+        typedef std::list<KeyType> UsageList;
+
+        struct Entry
+        {
+            itk::DataObject::Pointer m_Object;
+            SizeType m_Size;
+            UsageList::iterator m_Usage;
+        };
+
+        typedef std::map<KeyType,Entry> EntryMap;
+
+        EntryMap m_Entries;
+        UsageList m_UsageList;
+
+        SizeType m_MaximumSize;
+        SizeType m_Size;
+
+        unsigned long m_NumberOfHits;
+        unsigned long m_NumberOfMisses;
+        unsigned long m_NumberOfEvictions;
+    };
+
+} // namespace szi
+
+#endif // _sziImageCache_h_
@@ -0,0 +1,394 @@
+#ifndef _sziImagePack_h_
+#define _sziImagePack_h_
+
+#include <itkObject.h>
+#include <itkImage.h>
+#include <itkImportImageContainer.h>
+#include <itkIntTypes.h>
+
+#include "sziStreamable.h"
+#include "sziLogService.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace szi
+{
+
+    /**
+    Class to keep preprocessed (e.g. cropped) images in a single pack file, keyed by a string as in ImageCache,
+    such that the slaves of a job open one file instead of reading and cropping many image files each.
+    The file holds the raw pixel buffers, aligned to 64 bytes, followed by an index of the keys and image
+    geometries; it is memory-mapped read-only when opened, so that the images are views of the mapping, sharing the
+    pages of the operating system's file cache between the processes of a node, with no parsing of the pixels
+    (on Windows, the file is read into memory instead). The images hold a reference to the pack, which keeps
+    the mapping until the last of them is released; they must not be modified.
+    The pack is written and read on machines of the same byte order.
+    */
+    class ImagePack : public itk::Object
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef ImagePack Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::ImagePack, Object );
+
+        typedef std::string KeyType;
+
+        /** Start writing a new pack file. */
+        void create( const std::string& fn )
+        {
+            if ( this->m_Mapping )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "create(): " << this->m_FileName << " is open for reading" << End;
+            }
+            this->close();
+
+            this->m_Output.open( fn.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            if ( !this->m_Output )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "create(): cannot write to " << fn << End;
+            }
+            this->m_FileName = fn;
+
+            // the header is rewritten by close() with the position of the index
+            Header header;
+            this->m_Output.write( (const char*)&header, sizeof(header) );
+        }
+
+        /** Add an image to the pack being written, unless an image with the same key is already there. */
+        template < class TImage >
+        void addImage( const KeyType& key, const TImage* image )
+        {
+            if ( !this->m_Output.is_open() )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "addImage(): no pack is being written" << End;
+            }
+            if ( this->m_Entries.find( key ) != this->m_Entries.end() ) return;
+
+            const unsigned int dim = TImage::ImageDimension;
+            const typename TImage::RegionType& region = image->GetBufferedRegion();
+
+            Entry entry;
+            entry.pixelSize = sizeof(typename TImage::PixelType);
+            entry.size.resize( dim );
+            entry.origin.resize( dim );
+            entry.spacing.resize( dim );
+            entry.direction.resize( dim * dim );
+            for ( unsigned int i = 0; i < dim; i++ )
+            {
+                entry.size[i] = region.GetSize()[i];
+                entry.spacing[i] = image->GetSpacing()[i];
+                for ( unsigned int j = 0; j < dim; j++ ) entry.direction[i*dim+j] = image->GetDirection()[i][j];
+            }
+
+            // the origin of the buffer, which is indexed from zero in the pack
+            typename TImage::PointType origin;
+            image->TransformIndexToPhysicalPoint( region.GetIndex(), origin );
+            for ( unsigned int i = 0; i < dim; i++ ) entry.origin[i] = origin[i];
+
+            // align the pixels to 64 bytes
+            itk::uint64_t position = this->m_Output.tellp();
+            static const char padding[64] = { 0 };
+            if ( position % 64 ) this->m_Output.write( padding, 64 - position % 64 );
+
+            entry.offset = this->m_Output.tellp();
+            entry.length = region.GetNumberOfPixels() * entry.pixelSize;
+            this->m_Output.write( (const char*)image->GetBufferPointer(), entry.length );
+            if ( !this->m_Output )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "addImage(): cannot write " << key << " to " << this->m_FileName << End;
+            }
+
+            this->m_Entries[key] = entry;
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "addImage(): " << key << " (" << entry.length << " bytes)" << End;
+        }
+
+        /**
+        Open a pack file for reading, mapping it into memory. A pack is opened once: the images found in it
+        refer to its mapping, so open another pack object to read another file.
+        */
+        void open( const std::string& fn )
+        {
+            if ( this->m_Mapping || this->m_Output.is_open() )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): " << this->m_FileName << " is already open" << End;
+            }
+
+#ifdef _WIN32
+            std::ifstream ifs( fn.c_str(), std::ios::in | std::ios::binary );
+            ifs.seekg( 0, std::ios::end );
+            itk::uint64_t size = ifs ? (itk::uint64_t)ifs.tellg() : 0;
+            ifs.seekg( 0, std::ios::beg );
+            if ( !ifs || size < sizeof(Header) )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): cannot read " << fn << End;
+            }
+            char* p = new char[ size ];
+            if ( !ifs.read( p, size ) )
+            {
+                delete[] p;
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): cannot read " << fn << End;
+            }
+            this->m_Mapping = p;
+            this->m_MappingSize = size;
+#else
+            int fd = ::open( fn.c_str(), O_RDONLY );
+            struct stat st;
+            if ( fd < 0 || fstat( fd, &st ) != 0 || st.st_size < (off_t)sizeof(Header) )
+            {
+                if ( fd >= 0 ) ::close( fd );
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): cannot read " << fn << End;
+            }
+
+            // a read-only mapping: writing to an image of the pack is a fault
+            void* p = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            ::close( fd );
+            if ( p == MAP_FAILED )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): cannot map " << fn << End;
+            }
+            this->m_Mapping = (char*)p;
+            this->m_MappingSize = st.st_size;
+#endif
+            this->m_FileName = fn;
+
+            const Header* header = (const Header*)this->m_Mapping;
+            if ( std::string( header->magic, sizeof(header->magic) ) != std::string( Header().magic, sizeof(header->magic) ) ||
+                 header->indexOffset > this->m_MappingSize )
+            {
+                this->unmap();
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "open(): " << fn << " is not an image pack" << End;
+            }
+
+            StreamBuffer sb;
+            sb.streamIn( this->m_Mapping + header->indexOffset, this->m_MappingSize - header->indexOffset );
+            for ( itk::uint64_t k = 0; k < header->count; k++ )
+            {
+                KeyType key;
+                Entry entry;
+                sb >> key;
+                entry.streamIn( sb );
+                if ( entry.offset + entry.length > this->m_MappingSize ) continue;
+                this->m_Entries[key] = entry;
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "open(): " << this->m_Entries.size() << " images in " << fn << End;
+        }
+
+        /** Return the image of the key as a view of the mapped pack, or null if there is none or it has another pixel type. */
+        template < class TImage >
+        typename TImage::Pointer findImage( const KeyType& key ) const
+        {
+            typename TImage::Pointer image;
+
+            EntryMap::const_iterator i = this->m_Entries.find( key );
+            if ( !this->m_Mapping || i == this->m_Entries.end() ) return image;
+
+            const Entry& entry = i->second;
+            const unsigned int dim = TImage::ImageDimension;
+            if ( entry.pixelSize != sizeof(typename TImage::PixelType) || entry.size.size() != dim ) return image;
+
+            typename TImage::SizeType size;
+            typename TImage::PointType origin;
+            typename TImage::SpacingType spacing;
+            typename TImage::DirectionType direction;
+            for ( unsigned int d = 0; d < dim; d++ )
+            {
+                size[d] = entry.size[d];
+                origin[d] = entry.origin[d];
+                spacing[d] = entry.spacing[d];
+                for ( unsigned int j = 0; j < dim; j++ ) direction[d][j] = entry.direction[d*dim+j];
+            }
+
+            image = TImage::New();
+            image->SetRegions( size );
+            image->SetOrigin( origin );
+            image->SetSpacing( spacing );
+            image->SetDirection( direction );
+
+            // the buffer is not owned by the image, but its container keeps the pack, and so the mapping, alive
+            typedef PixelContainer<typename TImage::PixelType> ContainerType;
+            typename ContainerType::Pointer container = ContainerType::New();
+            container->setPack( this );
+            container->SetImportPointer( (typename TImage::PixelType*)( this->m_Mapping + entry.offset ), entry.length / entry.pixelSize, false );
+            image->SetPixelContainer( container );
+            return image;
+        }
+
+        bool isOpen() const { return this->m_Mapping != 0; }
+
+        const std::string& getFileName() const { return this->m_FileName; }
+
+        unsigned long getNumberOfImages() const { return this->m_Entries.size(); }
+
+        /** Finish writing the pack with its index; a pack being read is unmapped when it is destroyed. */
+        void close()
+        {
+            if ( this->m_Output.is_open() )
+            {
+                Header header;
+                header.indexOffset = this->m_Output.tellp();
+                header.count = this->m_Entries.size();
+
+                StreamBuffer sb;
+                for ( EntryMap::const_iterator i = this->m_Entries.begin(); i != this->m_Entries.end(); i++ )
+                {
+                    sb << i->first;
+                    i->second.streamOut( sb );
+                }
+                this->m_Output.write( (const char*)sb.getPointer(), sb.getSize() );
+                this->m_Output.seekp( 0 );
+                this->m_Output.write( (const char*)&header, sizeof(header) );
+                this->m_Output.close();
+                this->m_Entries.clear();
+
+                if ( !this->m_Output )
+                {
+                    this->m_Output.clear();
+                	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "close(): cannot write the index of " << this->m_FileName << End;
+                }
+
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "close(): " << header.count << " images written to " << this->m_FileName << End;
+            }
+        }
+
+    protected:
+        ImagePack() : m_Mapping(0), m_MappingSize(0) {}
+
+        /** Finish the pack being written, or unmap the pack read, once no image refers to it anymore. */
+        ~ImagePack()
+        {
+            try
+            {
+                this->close();
+            }
+            catch ( ... )
+            {
+            }
+
+            this->unmap();
+        }
+
+        void unmap()
+        {
+            if ( this->m_Mapping )
+            {
+#ifdef _WIN32
+                delete[] this->m_Mapping;
+#else
+                munmap( this->m_Mapping, this->m_MappingSize );
+#endif
+                this->m_Mapping = 0;
+                this->m_MappingSize = 0;
+                this->m_Entries.clear();
+            }
+        }
+
+        /** Container of the pixels of an image of the pack, holding a reference to the pack. */
+        template < class TPixel >
+        class PixelContainer : public itk::ImportImageContainer< itk::SizeValueType, TPixel >
+        {
+        public:
+            typedef PixelContainer Self;
+            typedef itk::ImportImageContainer< itk::SizeValueType, TPixel > Superclass;
+            typedef itk::SmartPointer< Self > Pointer;
+            typedef itk::SmartPointer< const Self > ConstPointer;
+
+            itkFactorylessNewMacro( Self );
+
+            itkTypeMacro( szi::ImagePack::PixelContainer, ImportImageContainer );
+
+            void setPack( const ImagePack* pack ) { this->m_Pack = pack; }
+
+        protected:
+            PixelContainer() {}
+
+        private:
+            PixelContainer( const Self & ); // purposely not implemented
+            PixelContainer& operator=( const Self & ); // purposely not implemented
+
+            ImagePack::ConstPointer m_Pack;
+        };
+
+        struct Header
+        {
+            char magic[8];
+            itk::uint64_t indexOffset;
+            itk::uint64_t count;
+
+            Header() : indexOffset(0), count(0) { std::memcpy( magic, "SZIPACK1", 8 ); }
+        };
+
+        /** Geometry and position of an image in the pack. */
+        struct Entry
+        {
+            unsigned int pixelSize;
+            std::vector<itk::uint64_t> size;
+            std::vector<double> origin;
+            std::vector<double> spacing;
+            std::vector<double> direction;
+            itk::uint64_t offset;
+            itk::uint64_t length;
+
+            Entry() : pixelSize(0), offset(0), length(0) {}
+
+            void streamOut( StreamBuffer& sb ) const
+            {
+                sb << pixelSize;
+                sb << (unsigned int)size.size();
+                for ( unsigned int i = 0; i < size.size(); i++ ) sb << size[i] << origin[i] << spacing[i];
+                for ( unsigned int i = 0; i < direction.size(); i++ ) sb << direction[i];
+                sb << offset << length;
+            }
+
+            void streamIn( StreamBuffer& sb )
+            {
+                unsigned int dim = 0;
+                sb >> pixelSize;
+                sb >> dim;
+                size.resize( dim );
+                origin.resize( dim );
+                spacing.resize( dim );
+                direction.resize( dim * dim );
+                for ( unsigned int i = 0; i < dim; i++ ) sb >> size[i] >> origin[i] >> spacing[i];
+                for ( unsigned int i = 0; i < direction.size(); i++ ) sb >> direction[i];
+                sb >> offset >> length;
+            }
+        };
+
+    private:
+        ImagePack( const Self & ); // purposely not implemented
+        ImagePack& operator=( const Self & ); // purposely not implemented
+
+        typedef std::map<KeyType,Entry> EntryMap;
+        EntryMap m_Entries;
+
+        std::string m_FileName;
+        std::ofstream m_Output;
+
+        char* m_Mapping;
+        itk::uint64_t m_MappingSize;
+    };
+
+} // namespace szi
+
+#endif // _sziImagePack_h_
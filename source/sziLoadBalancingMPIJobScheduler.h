@@ -0,0 +1,122 @@
+#ifndef _sziLoadBalancingMPIJobScheduler_h_
+#define _sziLoadBalancingMPIJobScheduler_h_
+
+#include <itkObject.h>
+#include "sziMPIJobScheduler.h"
+
+#include <map>
+
+namespace szi
+{
+
+    /**
+    Job scheduler that keeps track of the throughput of each worker, and hands out the
+    job served by the fastest idle worker first. Together with callers that submit the
+    longest evaluations first (see SystemTrainingMetric), the long computations are started
+    on the fastest workers, and the short ones fill in the gaps on the other workers.
+    The throughput of a worker is an exponentially weighted moving average of the ratio between
+    the expected and the measured times of its jobs.
+    */
+    class LoadBalancingMPIJobScheduler : public MPIJobScheduler
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef LoadBalancingMPIJobScheduler Self;
+        typedef MPIJobScheduler Superclass;
+        typedef itk::SmartPointer<Self> Pointer;
+        typedef itk::SmartPointer<const Self> ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::LoadBalancingMPIJobScheduler, szi::MPIJobScheduler );
+
+        /** Set/get the weight of the latest measurement in the moving averages. */
+        void setSmoothingFactor( double alpha ) { this->m_SmoothingFactor = alpha; }
+        double getSmoothingFactor() const { return this->m_SmoothingFactor; }
+
+        /** Return the job, not in use, that is served by the worker with the highest throughput. */
+        virtual RankType acquireJob()
+        {
+            this->initializeIdleJobs();
+
+            if ( this->m_IdleJobs.empty() ) return -1;
+
+            RankList::iterator best = this->m_IdleJobs.begin();
+            for ( RankList::iterator i = this->m_IdleJobs.begin(); i != this->m_IdleJobs.end(); i++ )
+            {
+                if ( this->getThroughput( this->getWorkerRankOfJob( *i ) ) > this->getThroughput( this->getWorkerRankOfJob( *best ) ) )
+                {
+                    best = i;
+                }
+            }
+
+            RankType rank = *best;
+            this->m_IdleJobs.erase( best );
+            return rank;
+        }
+
+        /** Update the throughput of the worker that served the job. */
+        virtual void recordJobTime( RankType rank, double expected, double actual )
+        {
+            WorkerStatistics& stats = this->m_Statistics[ this->getWorkerRankOfJob( rank ) ];
+            stats.m_NumberOfJobs++;
+            stats.m_BusyTime += actual;
+
+            if ( expected > 0 && actual > 0 )
+            {
+                double ratio = expected / actual;
+                if ( stats.m_Throughput > 0 )
+                {
+                    stats.m_Throughput += this->m_SmoothingFactor * ( ratio - stats.m_Throughput );
+                }
+                else
+                {
+                    stats.m_Throughput = ratio;
+                }
+            }
+        }
+
+        /** Return the relative throughput of a worker, one if it is not known yet. */
+        double getThroughput( RankType wrank ) const
+        {
+            StatisticsMap::const_iterator i = this->m_Statistics.find( wrank );
+            if ( i == this->m_Statistics.end() || i->second.m_Throughput <= 0 ) return 1.0;
+            return i->second.m_Throughput;
+        }
+
+        /** Report the statistics of the workers. */
+        virtual void terminate()
+        {
+            for ( StatisticsMap::const_iterator i = this->m_Statistics.begin(); i != this->m_Statistics.end(); i++ )
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "terminate(): worker " << i->first << ": " << i->second.m_NumberOfJobs << " jobs, " << i->second.m_BusyTime << " s busy, throughput = " << this->getThroughput( i->first ) << End;
+            }
+        }
+
+    protected:
+        LoadBalancingMPIJobScheduler() : m_SmoothingFactor(0.3) {}
+
+    private:
+        LoadBalancingMPIJobScheduler( const Self & ); // purposely not implemented
+        LoadBalancingMPIJobScheduler& operator=( const Self & ); // purposely not implemented
+
+        struct WorkerStatistics
+        {
+            unsigned int m_NumberOfJobs;
+            double m_BusyTime;
+            double m_Throughput;
+
+            WorkerStatistics() : m_NumberOfJobs(0), m_BusyTime(0), m_Throughput(0) {}
+        };
+
+        typedef std::map<RankType,WorkerStatistics> StatisticsMap;
+        StatisticsMap m_Statistics;
+
+        double m_SmoothingFactor;
+    };
+
+} // namespace szi
+
+#endif // _sziLoadBalancingMPIJobScheduler_h_
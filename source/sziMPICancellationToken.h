@@ -0,0 +1,52 @@
+#ifndef _sziMPICancellationToken_h_
+#define _sziMPICancellationToken_h_
+
+#include "sziCancellationToken.h"
+#include "sziMPIContext.h"
+
+namespace szi
+{
+
+    /**
+    Cancellation token of a slave, which is cancelled by a message with the given tag from the master.
+    Polling does not block, so it is cheap enough to be done at each iteration of a registration.
+    */
+    class MPICancellationToken : public CancellationToken
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef MPICancellationToken Self;
+        typedef CancellationToken Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::MPICancellationToken, szi::CancellationToken );
+
+        typedef MPIContext::RankType RankType;
+
+        /** Set the rank of the worker that sends the cancellation requests, and their tag. */
+        void setSource( RankType rank, int tag ) { this->m_SourceRank = rank; this->m_Tag = tag; }
+
+    protected:
+        MPICancellationToken() : m_SourceRank(0), m_Tag(MPIContext::TAG_EXIT) {}
+
+        virtual bool poll()
+        {
+            return MPIContext::poll( this->m_SourceRank, this->m_Tag );
+        }
+
+    private:
+        MPICancellationToken( const Self & ); // purposely not implemented
+        MPICancellationToken& operator=( const Self & ); // purposely not implemented
+
+        RankType m_SourceRank;
+        int m_Tag;
+    };
+
+} // namespace szi
+
+#endif // _sziMPICancellationToken_h_
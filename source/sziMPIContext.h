@@ -4,6 +4,7 @@
 #include <mpi.h>
 
 #include "sziStreamable.h"
+#include <set>
 #include <string>
 
 namespace szi
@@ -36,12 +37,37 @@ namespace szi
             return rank;
         }
 
-        static void terminateAllSlaves()
+        /**
+        Return the level of thread support provided by the MPI library (MPI_THREAD_SINGLE, MPI_THREAD_FUNNELED,
+        MPI_THREAD_SERIALIZED or MPI_THREAD_MULTIPLE), as negotiated with MPI_Init_thread().
+        */
+        static int getThreadSupport()
+        {
+            int provided = MPI_THREAD_SINGLE;
+            MPI_Query_thread( &provided );
+            return provided;
+        }
+
+        static const char* getThreadSupportName( int level )
+        {
+            switch ( level )
+            {
+            case MPI_THREAD_SINGLE: return "MPI_THREAD_SINGLE";
+            case MPI_THREAD_FUNNELED: return "MPI_THREAD_FUNNELED";
+            case MPI_THREAD_SERIALIZED: return "MPI_THREAD_SERIALIZED";
+            case MPI_THREAD_MULTIPLE: return "MPI_THREAD_MULTIPLE";
+            }
+            return "unknown";
+        }
+
+        /** Tell all the slaves to exit, except the excluded ones (e.g. those that hung or died, which would block). */
+        static void terminateAllSlaves( const std::set<RankType>& excluded = std::set<RankType>() )
         {
             NumberOfWorkersType nranks = getNumberOfWorkers();
             //
             for ( RankType i = 1; i < (RankType)nranks; i++ )
             {
+                if ( excluded.count( i ) ) continue;
                 MPIContext::send( i, TAG_EXIT );
             }
         }
@@ -60,6 +86,25 @@ namespace szi
             );
         }
 
+        /**
+        Block until a message from any source (or the specified source) is available,
+        without receiving it, and return the rank of its source. The tag of the message
+        is returned in the optional output argument.
+        */
+        static RankType probe( RankType rank = MPI_ANY_SOURCE, int* tag = 0 )
+        {
+            MPI_Status status;
+            MPI_Probe
+            (
+                rank, // source process
+                MPI_ANY_TAG, // user-defined message tag
+                MPI_COMM_WORLD, // communicator to receive the message
+                &status // info about the available message
+            );
+            if ( tag ) *tag = status.MPI_TAG;
+            return status.MPI_SOURCE;
+        }
+
         /** Receive a single tag from a source. */
         static int receive( RankType rank )
         {
@@ -77,27 +122,47 @@ namespace szi
             return status.MPI_TAG;
         }
 
+        /**
+        Receive a single tag from a source if such a message is available, without blocking.
+        Return true if the message has been received.
+        */
+        static bool poll( RankType rank, int tag )
+        {
+            int flag = 0;
+            MPI_Status status;
+            MPI_Iprobe( rank, tag, MPI_COMM_WORLD, &flag, &status );
+            if ( !flag ) return false;
+
+            MPI_Recv( 0, 0, MPI_CHAR, rank, tag, MPI_COMM_WORLD, &status );
+            return true;
+        }
+
         // sending/receiving data of type szi::Streamable through MPI
         static void send( const Streamable& s, RankType rank, int tag )
         {
             StreamBuffer sb;
+            MPIContext::send( s, rank, tag, sb );
+        }
+        //
+        static void receive( Streamable& s, RankType rank, int tag )
+        {
+            StreamBuffer sb;
+            MPIContext::receive( s, rank, tag, sb );
+        }
+
+        /**
+        Send data of type szi::Streamable in a single message, using a buffer provided by the caller,
+        which is reused across calls (e.g. one per communication channel) to avoid memory allocations.
+        */
+        static void send( const Streamable& s, RankType rank, int tag, StreamBuffer& sb )
+        {
+            sb.flush();
             sb << s;
             //
-            long size = sb.getSize();
-            MPI_Send
-            (
-                &size,
-                1,
-                MPI_LONG,
-                rank,
-                tag,
-                MPI_COMM_WORLD
-            );
-            //
             MPI_Send
             (
                 sb.getPointer(),
-                size,
+                sb.getSize(),
                 MPI_CHAR,
                 rank,
                 tag,
@@ -105,37 +170,29 @@ namespace szi
             );
         }
         //
-        static void receive( Streamable& s, RankType rank, int tag )
+        /**
+        Receive data of type szi::Streamable sent in a single message: the size of the message is
+        obtained by probing, and the message is received directly into the buffer provided by the caller.
+        */
+        static void receive( Streamable& s, RankType rank, int tag, StreamBuffer& sb )
         {
             MPI_Status status;
+            MPI_Probe( rank, tag, MPI_COMM_WORLD, &status );
             //
-            long size = 0;
-            MPI_Recv
-            (
-                &size,
-                1,
-                MPI_LONG,
-                rank,
-                tag,
-                MPI_COMM_WORLD,
-                &status
-            );
+            int size = 0;
+            MPI_Get_count( &status, MPI_CHAR, &size );
             //
-            char* buf = new char[size];
             MPI_Recv
             (
-                buf,
+                sb.reset( size ),
                 size,
                 MPI_CHAR,
-                rank,
-                tag,
+                status.MPI_SOURCE,
+                status.MPI_TAG,
                 MPI_COMM_WORLD,
                 &status
             );
             //
-            StreamBuffer sb;
-            sb.streamIn( buf, size );
-            delete[] buf;
             sb >> s;
         }
 
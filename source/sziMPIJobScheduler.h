@@ -9,6 +9,9 @@
 #include "sziMPIJob.h"
 #include "sziMPIWorker.h"
 
+#include <deque>
+#include <list>
+
 namespace szi
 {
 
@@ -113,7 +116,7 @@ namespace szi
         virtual void startJob( RankType rank )
         {
         	JobType* job = this->getJob( rank );
-        	RankType wrank = rank + 1;
+        	RankType wrank = this->getWorkerRankOfJob( rank );
         	WorkerType* worker = this->getWorker( wrank );
 
         	worker->setState( WorkerType::WORKER_IDLE );
@@ -126,7 +129,7 @@ namespace szi
         virtual void endJob( RankType rank )
         {
         	JobType* job = this->getJob( rank );
-        	RankType wrank = rank + 1;
+        	RankType wrank = this->getWorkerRankOfJob( rank );
         	WorkerType* worker = this->getWorker( wrank );
 
         	worker->setState( WorkerType::WORKER_UNKNOWN );
@@ -134,19 +137,54 @@ namespace szi
         }
 
         /**
-         * Put a job into waiting list for subsequent execution.
+         * Return the rank of a job that is not in use by any caller, and mark it as in use,
+         * or -1 if all jobs are in use. The job is given back with releaseJob().
          */
-        virtual void runJob( RankType rank, bool wait = false )
+        virtual RankType acquireJob()
         {
-            JobType* job = this->getJob( rank );
-            RankType wrank = rank + 1;
-            WorkerType* worker = this->getWorker( wrank );
+            this->initializeIdleJobs();
 
-            worker->setState( WorkerType::WORKER_BUSY );
-            job->execute();
-            worker->setState( WorkerType::WORKER_IDLE );
+            if ( this->m_IdleJobs.empty() ) return -1;
+
+            RankType rank = this->m_IdleJobs.front();
+            this->m_IdleJobs.pop_front();
+            return rank;
+        }
+
+        /**
+         * Same as acquireJob(), but return the preferred job if it is not in use, e.g. because
+         * its worker already holds the data to be processed.
+         */
+        virtual RankType acquirePreferredJob( RankType preferred )
+        {
+            this->initializeIdleJobs();
+
+            for ( RankList::iterator i = this->m_IdleJobs.begin(); i != this->m_IdleJobs.end(); i++ )
+            {
+                if ( (*i) == preferred )
+                {
+                    this->m_IdleJobs.erase( i );
+                    return preferred;
+                }
+            }
+            return this->acquireJob();
+        }
+
+        /**
+         * Give back a job that was previously returned by acquireJob().
+         */
+        virtual void releaseJob( RankType rank )
+        {
+            this->m_IdleJobs.push_back( rank );
         }
 
+        /**
+         * Record the time spent by a job from its start to its end, together with the time
+         * it was expected to take (zero if unknown), for schedulers that balance the load
+         * according to the measured performance of the workers.
+         */
+        virtual void recordJobTime( RankType rank, double expected, double actual ) {}
+
         /**
         Abstract function to be implemented in subclasses.
         It performs the actual job scheduling operation.
@@ -234,7 +272,26 @@ namespace szi
         typedef std::list<WorkerPointer> WorkerList;
         WorkerList m_WorkerList;
 
-        MPIJobScheduler() {}
+        /** Return the rank of the worker that serves a job: each job has a slave worker of its own. */
+        RankType getWorkerRankOfJob( RankType rank ) const { return rank + 1; }
+
+        /** Fill the list of jobs not in use with all jobs, the first time it is needed. */
+        void initializeIdleJobs()
+        {
+            if ( this->m_IdleJobsInitialized ) return;
+
+            for ( JobList::const_iterator i = this->m_JobList.begin(); i != this->m_JobList.end(); i++ )
+            {
+                this->m_IdleJobs.push_back( (*i)->getRank() );
+            }
+            this->m_IdleJobsInitialized = true;
+        }
+
+        typedef std::deque<RankType> RankList;
+        RankList m_IdleJobs;
+        bool m_IdleJobsInitialized;
+
+        MPIJobScheduler() : m_IdleJobsInitialized(false) {}
 
     private:
         MPIJobScheduler( const Self & ); // purposely not implemented
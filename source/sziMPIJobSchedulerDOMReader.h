@@ -4,7 +4,7 @@
 #include <itkDOMReader.h>
 #include "sziMPIJobScheduler.h"
 
-#include "sziSimpleMPIJobScheduler.h"
+#include "sziLoadBalancingMPIJobScheduler.h"
 
 #include "sziLogService.h"
 
@@ -42,10 +42,27 @@ namespace szi
 				this->SetOutput( output );
             }
 
+            // the jobs are no longer run by the scheduler, so the threaded scheduler is replaced by the simpliest one
             else if ( tagname == "SimpleMPIJobScheduler" )
 			{
-				typedef SimpleMPIJobScheduler RealOutputType;
+				getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): SimpleMPIJobScheduler is no longer available, MPIJobScheduler is used instead" << End;
+				OutputType::Pointer output = OutputType::New();
+				this->SetOutput( output );
+			}
+
+            else if ( tagname == "LoadBalancingMPIJobScheduler" )
+			{
+				typedef LoadBalancingMPIJobScheduler RealOutputType;
 				RealOutputType::Pointer object = RealOutputType::New();
+
+				itk::FancyString s = inputdom->GetAttribute("SmoothingFactor");
+				if ( s != "" )
+				{
+					double alpha = 0; s >> alpha;
+					object->setSmoothingFactor( alpha );
+					getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): SmoothingFactor = " << alpha << End;
+				}
+
 				OutputType* output = (RealOutputType*)object;
 				this->SetOutput( output );
 			}
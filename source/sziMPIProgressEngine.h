@@ -0,0 +1,267 @@
+#ifndef _sziMPIProgressEngine_h_
+#define _sziMPIProgressEngine_h_
+
+#include <itkObject.h>
+
+#include "sziMPIContext.h"
+#include "sziLogService.h"
+
+#include <vector>
+
+namespace szi
+{
+
+    /**
+    Class to drive a number of outstanding non-blocking MPI requests from a single thread.
+    Requests are posted with MPI_Isend/MPI_Irecv on behalf of a handler, and progress() completes
+    them with MPI_Testsome (or MPI_Waitsome when asked to wait), calling back the handler of each
+    completed request, which may in turn post new requests.
+    When MPI returns errors instead of aborting (MPI_ERRORS_RETURN, e.g. because a slave has died),
+    the handler of a failed request is called with the error code in the MPI_ERROR field of the status,
+    which is MPI_SUCCESS otherwise.
+    */
+    class MPIProgressEngine : public itk::Object
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef MPIProgressEngine Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::MPIProgressEngine, Object );
+
+        typedef MPIContext::RankType RankType;
+
+        /**
+        Abstract class (interface) to be notified of the completion of posted requests.
+        */
+        class Handler
+        {
+        public:
+            /** Abstract method called when the request posted with the given ID completes. */
+            virtual void requestCompleted( int id, const MPI_Status& status ) = 0;
+
+            virtual ~Handler() {}
+        };
+
+        /** Post a send of count bytes from the buffer, which must stay valid until completion. */
+        void postSend( const void* buf, int count, RankType rank, int tag, Handler* handler, int id )
+        {
+            MPI_Request request = MPI_REQUEST_NULL;
+            int error = MPI_Isend( (void*)buf, count, MPI_CHAR, rank, tag, MPI_COMM_WORLD, &request );
+            this->add( request, handler, id, error );
+        }
+
+        /** Post a receive of at most count bytes into the buffer, which must stay valid until completion. */
+        void postReceive( void* buf, int count, RankType rank, int tag, Handler* handler, int id )
+        {
+            MPI_Request request = MPI_REQUEST_NULL;
+            int error = MPI_Irecv( buf, count, MPI_CHAR, rank, tag, MPI_COMM_WORLD, &request );
+            this->add( request, handler, id, error );
+        }
+
+        /** Cancel all the outstanding requests of a handler (e.g. a receive that will never be matched). */
+        void cancel( Handler* handler )
+        {
+            for ( size_t i = 0; i < this->m_Requests.size(); i++ )
+            {
+                if ( this->m_Entries[i].m_Handler == handler && this->m_Requests[i] != MPI_REQUEST_NULL )
+                {
+                    MPI_Cancel( &this->m_Requests[i] );
+                    MPI_Request_free( &this->m_Requests[i] );
+                    this->m_Entries[i].m_Handler = 0;
+                }
+            }
+            size_t j = 0;
+            for ( size_t i = 0; i < this->m_Failed.size(); i++ )
+            {
+                if ( this->m_Failed[i].m_Handler != handler ) this->m_Failed[j++] = this->m_Failed[i];
+            }
+            this->m_Failed.resize( j );
+            this->compact();
+        }
+
+        /** Return the number of outstanding requests, in total or of a handler. */
+        unsigned int getNumberOfRequests( const Handler* handler = 0 ) const
+        {
+            if ( handler == 0 ) return this->m_Requests.size() + this->m_Failed.size();
+
+            unsigned int n = 0;
+            for ( size_t i = 0; i < this->m_Entries.size(); i++ )
+            {
+                if ( this->m_Entries[i].m_Handler == handler ) n++;
+            }
+            for ( size_t i = 0; i < this->m_Failed.size(); i++ )
+            {
+                if ( this->m_Failed[i].m_Handler == handler ) n++;
+            }
+            return n;
+        }
+
+        /**
+        Complete the requests that are ready, and call their handlers. If wait is true, block until at
+        least one request completes. Return the number of requests completed.
+        */
+        unsigned int progress( bool wait = false )
+        {
+            // the requests that could not be posted complete first, with their errors
+            if ( !this->m_Failed.empty() )
+            {
+                std::vector<Entry> failed;
+                failed.swap( this->m_Failed );
+                for ( size_t k = 0; k < failed.size(); k++ )
+                {
+                    if ( failed[k].m_Handler ) failed[k].m_Handler->requestCompleted( failed[k].m_Id, this->errorStatus( failed[k].m_Error ) );
+                }
+                return failed.size();
+            }
+
+            int n = (int)this->m_Requests.size();
+            if ( n == 0 ) return 0;
+
+            int ndone = 0;
+            this->m_Indices.resize( n );
+            this->m_Statuses.resize( n );
+            int error = MPI_SUCCESS;
+            if ( wait )
+            {
+                error = MPI_Waitsome( n, &this->m_Requests[0], &ndone, &this->m_Indices[0], &this->m_Statuses[0] );
+            }
+            else
+            {
+                error = MPI_Testsome( n, &this->m_Requests[0], &ndone, &this->m_Indices[0], &this->m_Statuses[0] );
+            }
+            if ( error != MPI_SUCCESS && error != MPI_ERR_IN_STATUS )
+            {
+                return this->progressOneByOne();
+            }
+            if ( ndone == MPI_UNDEFINED || ndone <= 0 ) return 0;
+
+            // take the completed requests out before calling the handlers, which may post new requests
+            std::vector<Entry> done( ndone );
+            std::vector<MPI_Status> statuses( this->m_Statuses.begin(), this->m_Statuses.begin() + ndone );
+            for ( int k = 0; k < ndone; k++ )
+            {
+                // the error fields of the statuses are only set when some request has failed
+                if ( error == MPI_SUCCESS ) statuses[k].MPI_ERROR = MPI_SUCCESS;
+
+                done[k] = this->m_Entries[ this->m_Indices[k] ];
+                this->m_Entries[ this->m_Indices[k] ].m_Handler = 0;
+                this->m_Requests[ this->m_Indices[k] ] = MPI_REQUEST_NULL;
+            }
+            this->compact();
+
+            for ( int k = 0; k < ndone; k++ )
+            {
+                if ( done[k].m_Handler ) done[k].m_Handler->requestCompleted( done[k].m_Id, statuses[k] );
+            }
+
+            return (unsigned int)ndone;
+        }
+
+    protected:
+        MPIProgressEngine() {}
+
+        /** Add a posted request, or one that could not be posted, to complete with its error at the next progress. */
+        void add( MPI_Request request, Handler* handler, int id, int error )
+        {
+            Entry e;
+            e.m_Handler = handler;
+            e.m_Id = id;
+            e.m_Error = error;
+            if ( error != MPI_SUCCESS )
+            {
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "add(): request " << id << " could not be posted, MPI error " << error << End;
+                this->m_Failed.push_back( e );
+                return;
+            }
+            this->m_Requests.push_back( request );
+            this->m_Entries.push_back( e );
+        }
+
+        /** Return a status reporting an error. */
+        static MPI_Status errorStatus( int error )
+        {
+            MPI_Status status;
+            status.MPI_SOURCE = MPI_ANY_SOURCE;
+            status.MPI_TAG = MPI_ANY_TAG;
+            status.MPI_ERROR = error;
+            return status;
+        }
+
+        /**
+        Complete the requests that are ready one by one, when MPI could not tell which request has failed,
+        the requests failing being completed with their errors. Return the number of requests completed.
+        */
+        unsigned int progressOneByOne()
+        {
+            std::vector<Entry> done;
+            std::vector<MPI_Status> statuses;
+            for ( size_t i = 0; i < this->m_Requests.size(); i++ )
+            {
+                int flag = 0;
+                MPI_Status status;
+                int error = MPI_Test( &this->m_Requests[i], &flag, &status );
+                if ( error == MPI_SUCCESS && !flag ) continue;
+
+                if ( error == MPI_SUCCESS ) status.MPI_ERROR = MPI_SUCCESS;
+                else status = this->errorStatus( error );
+                done.push_back( this->m_Entries[i] );
+                statuses.push_back( status );
+                this->m_Entries[i].m_Handler = 0;
+                this->m_Requests[i] = MPI_REQUEST_NULL;
+            }
+            this->compact();
+
+            for ( size_t k = 0; k < done.size(); k++ )
+            {
+                if ( done[k].m_Handler ) done[k].m_Handler->requestCompleted( done[k].m_Id, statuses[k] );
+            }
+
+            return done.size();
+        }
+
+        /** Remove the completed (null) requests. */
+        void compact()
+        {
+            size_t j = 0;
+            for ( size_t i = 0; i < this->m_Requests.size(); i++ )
+            {
+                if ( this->m_Requests[i] == MPI_REQUEST_NULL ) continue;
+                this->m_Requests[j] = this->m_Requests[i];
+                this->m_Entries[j] = this->m_Entries[i];
+                j++;
+            }
+            this->m_Requests.resize( j );
+            this->m_Entries.resize( j );
+        }
+
+    private:
+        MPIProgressEngine( const Self & ); // purposely not implemented
+        MPIProgressEngine& operator=( const Self & ); // purposely not implemented
+
+        struct Entry
+        {
+            Handler* m_Handler;
+            int m_Id;
+            int m_Error;
+        };
+
+        std::vector<MPI_Request> m_Requests;
+        std::vector<Entry> m_Entries;
+
+        /** Requests that could not be posted, to be completed with their errors. */
+        std::vector<Entry> m_Failed;
+
+        std::vector<int> m_Indices;
+        std::vector<MPI_Status> m_Statuses;
+    };
+
+} // namespace szi
+
+#endif // _sziMPIProgressEngine_h_
@@ -4,6 +4,14 @@
 #include "sziSystem.h"
 #include "sziMPISystemParametersTunerContext.h"
 #include "sziMPIJobScheduler.h"
+#include "sziMPIProgressEngine.h"
+
+#include <itkRealTimeClock.h>
+#include <itksys/SystemTools.hxx>
+
+#include <list>
+#include <map>
+#include <set>
 
 namespace szi
 {
@@ -12,8 +20,20 @@ namespace szi
     Master-side implementation of System. It receives requests from the master and
     forwards them to an available slave to complete the requested jobs, then gets the results
     from the slave and forwards them to the master.
+    Each job of the scheduler is a channel to one slave; the tuner-side agent dispatches
+    evaluations to the idle channels chosen by the scheduler, so any training example can be
+    evaluated by any slave, and collects the results in the order the slaves finish.
+    Each training example is preferably sent to the slave that evaluated it before; once a slave
+    holds an example, only the example ID and the parameters are sent to it.
+    All the communication with the slaves is done with non-blocking requests, which are driven
+    by a single progress engine on the calling thread, rather than by one thread per slave.
+    A cancelled evaluation in progress is stopped by its slave, which polls for the request.
+    An evaluation that fails on a slave, or does not finish in time, is retried on another slave;
+    slaves that fail repeatedly, hang or die (MPI returning an error for their requests, see
+    MPIProgressEngine) are no longer used. When the retries are exhausted, the evaluation is either
+    given a failure score, or the tuning is aborted.
     */
-    class MPISystemAgent : public System
+    class MPISystemAgent : public System, public MPIProgressEngine::Handler
     {
     public:
         /** Standard class typedefs. */
@@ -32,88 +52,608 @@ namespace szi
 
         typedef MPIJob::RankType RankType;
 
+        /** States of the evaluation in progress on a channel. */
+        enum ChannelState { CHANNEL_IDLE=0, CHANNEL_UPDATING, CHANNEL_COLLECTING, CHANNEL_DONE, CHANNEL_FAILED };
+
         virtual void setJobScheduler( SchedulerType* scheduler ) { this->m_JobScheduler = scheduler; }
         virtual SchedulerType* getJobScheduler() const { return this->m_JobScheduler; }
 
-        virtual MeasureType getPerformanceScore() const
+        /**
+        Set/get the time (in seconds) after which an evaluation in progress is considered lost and its
+        slave hung, or zero (the default) to wait forever.
+        */
+        virtual void setEvaluationTimeout( double t ) { this->m_EvaluationTimeout = t; }
+        double getEvaluationTimeout() const { return this->m_EvaluationTimeout; }
+
+        /** Set/get the number of times a failed evaluation is retried on another slave (2 by default). */
+        virtual void setMaximumNumberOfRetries( unsigned int n ) { this->m_MaximumNumberOfRetries = n; }
+        unsigned int getMaximumNumberOfRetries() const { return this->m_MaximumNumberOfRetries; }
+
+        /** Set/get the number of consecutive failures after which a slave is no longer used (3 by default). */
+        virtual void setMaximumNumberOfFailuresPerSlave( unsigned int n ) { this->m_MaximumNumberOfFailuresPerSlave = n; }
+        unsigned int getMaximumNumberOfFailuresPerSlave() const { return this->m_MaximumNumberOfFailuresPerSlave; }
+
+        /**
+        Set the score given to an evaluation that still fails after all the retries, instead of aborting
+        the tuning (the default), e.g. the worst possible score such that the parameters are avoided.
+        */
+        virtual void setFailureScore( MeasureType score ) { this->m_FailureScore = score; this->m_UseFailureScore = true; }
+        MeasureType getFailureScore() const { return this->m_FailureScore; }
+        bool getUseFailureScore() const { return this->m_UseFailureScore; }
+
+        /**
+        Send the evaluation request to an idle slave (channel), and return right away without waiting
+        for the slave to finish the computation. If all the slaves are busy, wait for the first
+        pending evaluation to finish, whichever it is.
+        */
+        virtual EvaluationPointer submitEvaluation( DataType* data, const ParametersType& params, double fidelity = 1.0 )
         {
-            const DataType* data = this->getData();
+            EvaluationPointer evaluation = EvaluationType::New();
+            evaluation->setData( data );
+            evaluation->setParameters( params );
+            evaluation->setFidelity( fidelity );
 
-            data->m_OpId = MPISystemParametersTunerContext::TAG_SPT_GET_SCORE;
+            // prefer the channel that evaluated this training example last time
+            AffinityMap::const_iterator last = this->m_ExampleChannels.find( data->m_ExampleId );
+            RankType channel = this->acquireChannel( last != this->m_ExampleChannels.end() ? last->second : -1 );
 
-            // will block until job execution is finished
-            this->getJobScheduler()->runJob( data->m_Rank, true );
-            this->getJobScheduler()->endJob( data->m_Rank );
+            evaluation->setState( EvaluationType::EVALUATION_SUBMITTED );
+            this->m_PendingEvaluations.push_back( evaluation );
 
-            const_cast<Self*>(this)->setPerformanceScore( data->m_Score );
+            this->dispatchEvaluation( evaluation, channel );
+
+            return evaluation;
+        }
+
+        /**
+        Collect the score of a submitted evaluation from the slave, blocking until it is available.
+        The evaluations that finish in the meantime are collected as well, to free their slaves.
+        */
+        virtual MeasureType waitEvaluation( EvaluationType* evaluation )
+        {
+            if ( !evaluation->isDone() && evaluation->getState() != EvaluationType::EVALUATION_SUBMITTED )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "waitEvaluation(): evaluation was not submitted to this system" << End;
+            }
+
+            while ( !evaluation->isDone() )
+            {
+                this->collectAnyEvaluation();
+            }
+            return evaluation->getScore();
+        }
+
+        /**
+        Give up a submitted evaluation. An evaluation waiting to be started again on another slave is
+        dropped; the slave of one in progress is requested to stop, and its score is discarded.
+        */
+        virtual void cancelEvaluation( EvaluationType* evaluation )
+        {
+            if ( evaluation->isDone() || evaluation->isCancelled() ) return;
+
+            evaluation->setState( EvaluationType::EVALUATION_CANCELLED );
+
+            if ( evaluation->getChannel() < 0 )
+            {
+                this->m_PendingEvaluations.remove( evaluation );
+            }
+            else
+            {
+                this->getChannel( evaluation->getChannel() )->stopEvaluation();
+            }
+        }
+
+        /** Return the estimated time of evaluating a training example, from previous evaluations. */
+        virtual double getEstimatedEvaluationTime( const DataType* data ) const
+        {
+            TimeMap::const_iterator i = this->m_EstimatedTimes.find( data );
+            return ( i == this->m_EstimatedTimes.end() ? 0.0 : i->second );
+        }
+
+        /** Each job of the scheduler is a channel to one slave, so as many evaluations as usable jobs can be in progress. */
+        virtual unsigned int getNumberOfConcurrentEvaluations() const
+        {
+            unsigned int njobs = this->getNumberOfUsableChannels();
+            return ( njobs ? njobs : 1 );
+        }
+
+        virtual MeasureType getPerformanceScore() const
+        {
+            Self* self = const_cast<Self*>( this );
+
+            if ( self->m_LastEvaluation )
+            {
+                self->setPerformanceScore( self->waitEvaluation( self->m_LastEvaluation ) );
+            }
 
             return Superclass::getPerformanceScore();
         }
 
         virtual void updatePerformanceScore()
+        {
+            this->m_LastEvaluation = this->submitEvaluation( this->getData(), this->getTunableParameters(), this->getFidelity() );
+        }
+
+        /**
+        Post the non-blocking requests to have the slave of this channel compute the score of its data:
+        the command, the data, and the reply sent by the slave once the score is computed. With the fused
+        TAG_SPT_EVALUATE requests, the reply carries the score; with the two-phase TAG_SPT_UPDATE_SCORE
+        requests, it is an acknowledgement, and the score is requested by requestCompleted().
+        */
+        void startEvaluation( MPIProgressEngine* engine )
         {
             DataType* data = this->getData();
+            RankType rank = this->getWorkerRank();
+            int tag = data->m_OpId;
+
+            if ( this->m_ChannelState == CHANNEL_UPDATING || this->m_ChannelState == CHANNEL_COLLECTING )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "startEvaluation(): an evaluation is already in progress on worker " << rank << End;
+            }
+
+            this->m_ProgressEngine = engine;
+            this->m_ChannelState = CHANNEL_UPDATING;
+            this->m_ScoreReceived = false;
+
+            // the buffer is not reused before all the requests of the previous evaluation have completed
+            this->m_Buffer.flush();
+            this->m_Buffer << (const Streamable&)(*data);
 
-            data->m_Parameters = this->getTunableParameters();
-            data->m_OpId = MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE;
+            engine->postSend( 0, 0, rank, tag, this, REQUEST_COMMAND );
+            engine->postSend( this->m_Buffer.getPointer(), this->m_Buffer.getSize(), rank, tag, this, REQUEST_DATA );
 
-            // just send the request to run this job, will return right away
-            this->getJobScheduler()->startJob( data->m_Rank );
-            this->getJobScheduler()->runJob( data->m_Rank );
+            if ( tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE ||
+                 tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID )
+            {
+                // the slave pushes the score (or an empty failure message) as soon as it is computed
+                this->m_ChannelState = CHANNEL_COLLECTING;
+                engine->postReceive( &this->m_ReceivedScore, sizeof(double), rank, MPI_ANY_TAG, this, REQUEST_SCORE );
+            }
+            else
+            {
+                engine->postReceive( 0, 0, rank, MPI_ANY_TAG, this, REQUEST_ACK );
+            }
         }
 
         /**
-        MPIJob method to process the data using the assigned worker.
-        This method is called by a slave worker agent, and runs in a thread.
+        Post the request to have the slave of this channel stop the fused evaluation in progress, if its score
+        has not been received yet. The slave then replies with a failure, unless it has sent the score already.
         */
-        virtual void execute()
+        void stopEvaluation()
         {
-            DataType* data = this->getData();
+            int tag = this->getData()->m_OpId;
+            if ( this->m_ChannelState != CHANNEL_COLLECTING || this->m_ScoreReceived ||
+                 ( tag != MPISystemParametersTunerContext::TAG_SPT_EVALUATE && tag != MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID ) )
+            {
+                return;
+            }
+
+            this->m_ProgressEngine->postSend( 0, 0, this->getWorkerRank(), MPISystemParametersTunerContext::TAG_SPT_CANCEL, this, REQUEST_CANCEL );
+        }
+
+        /** MPIProgressEngine::Handler method to advance the evaluation in progress on this channel. */
+        virtual void requestCompleted( int id, const MPI_Status& status )
+        {
+            MPIProgressEngine* engine = this->m_ProgressEngine;
             RankType rank = this->getWorkerRank();
 
-            if ( data->m_OpId == MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE )
+            // the slave cannot be reached anymore, e.g. it has died
+            if ( status.MPI_ERROR != MPI_SUCCESS )
             {
-                // send the command type to the slave worker
-                MPIContext::send( rank, MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE );
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "requestCompleted(): request " << id << " to worker " << rank << " failed, MPI error " << status.MPI_ERROR << End;
+                engine->cancel( this );
+                this->m_ChannelState = CHANNEL_FAILED;
+                this->m_WorkerLost = true;
+                return;
+            }
 
-                // send the system data to the slave worker
-                MPIContext::send( (Streamable&)(*data), rank, MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE );
+            if ( id == REQUEST_ACK )
+            {
+                if ( status.MPI_TAG != MPIContext::TAG_OK )
+                {
+                    this->m_ChannelState = CHANNEL_FAILED;
+                    return;
+                }
+
+                // the score has been computed, so request it
+                this->m_ChannelState = CHANNEL_COLLECTING;
+                engine->postSend( 0, 0, rank, MPISystemParametersTunerContext::TAG_SPT_GET_SCORE, this, REQUEST_COMMAND );
+                engine->postReceive( 0, 0, rank, MPI_ANY_TAG, this, REQUEST_STATUS );
+                engine->postReceive( &this->m_ReceivedScore, sizeof(double), rank, MPISystemParametersTunerContext::TAG_SPT_GET_SCORE, this, REQUEST_SCORE );
+            }
 
-                int tag = MPIContext::receive( rank );
-                if ( tag != MPIContext::TAG_OK )
+            else if ( id == REQUEST_STATUS )
+            {
+                if ( status.MPI_TAG != MPIContext::TAG_OK )
                 {
-                	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "execute(): communication failed!" << End;
+                    // the score will never be sent
+                    engine->cancel( this );
+                    this->m_ChannelState = CHANNEL_FAILED;
+                    return;
                 }
             }
 
-            else if ( data->m_OpId == MPISystemParametersTunerContext::TAG_SPT_GET_SCORE )
+            else if ( id == REQUEST_SCORE )
             {
-                // send the command type to the slave worker
-                MPIContext::send( rank, MPISystemParametersTunerContext::TAG_SPT_GET_SCORE );
+                if ( status.MPI_TAG == MPIContext::TAG_FAIL )
+                {
+                    this->m_ChannelState = CHANNEL_FAILED;
+                    return;
+                }
+                this->getData()->m_Score = this->m_ReceivedScore;
+                this->m_ScoreReceived = true;
+            }
 
-                int tag = MPIContext::receive( rank );
-                if ( tag != MPIContext::TAG_OK )
+            if ( this->m_ChannelState == CHANNEL_COLLECTING && this->m_ScoreReceived && engine->getNumberOfRequests( this ) == 0 )
+            {
+                this->m_ChannelState = CHANNEL_DONE;
+            }
+        }
+
+        ChannelState getChannelState() const { return this->m_ChannelState; }
+        bool isWorkerLost() const { return this->m_WorkerLost; }
+        void resetChannelState() { this->m_ChannelState = CHANNEL_IDLE; }
+
+    protected:
+        typedef std::list<EvaluationPointer> EvaluationList;
+
+        MPISystemAgent() : m_EvaluationTimeout(0), m_MaximumNumberOfRetries(2), m_MaximumNumberOfFailuresPerSlave(3),
+                           m_FailureScore(0), m_UseFailureScore(false),
+                           m_ChannelState(CHANNEL_IDLE), m_ReceivedScore(0), m_ScoreReceived(false), m_WorkerLost(false)
+        {
+            this->m_Clock = itk::RealTimeClock::New();
+        }
+
+        /**
+        Return the rank of a job (channel) that is not in use, the preferred one if possible,
+        waiting for the first pending evaluation to finish if all of them are busy.
+        */
+        RankType acquireChannel( RankType preferred = -1 )
+        {
+            RankType channel = this->tryAcquireChannel( preferred );
+            while ( channel < 0 )
+            {
+                if ( this->m_PendingEvaluations.empty() )
                 {
-                	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "execute(): communication failed!" << End;
+                    getSystemLogger() << StartFatal(this->GetNameOfClass()) << "acquireChannel(): no job available to run the evaluation" << End;
                 }
+                this->collectAnyEvaluation();
+                channel = this->tryAcquireChannel( preferred );
+            }
 
-                // wait for the result from the slave worker
-                double score = 0;
-                MPIContext::receive( score, rank, MPISystemParametersTunerContext::TAG_SPT_GET_SCORE );
+            return channel;
+        }
 
-                // update the score in the system data
-                data->m_Score = score;
+        /**
+        Return the rank of a job (channel) that is not in use, the preferred one if possible, and
+        another one than the excluded one unless it is the only usable channel; -1 if all are busy.
+        */
+        RankType tryAcquireChannel( RankType preferred, RankType excluded = -1 )
+        {
+            SchedulerType* scheduler = this->getJobScheduler();
+
+            RankType channel = scheduler->acquirePreferredJob( preferred );
+            if ( channel >= 0 && channel == excluded && this->getNumberOfUsableChannels() > 1 )
+            {
+                RankType other = scheduler->acquireJob();
+                scheduler->releaseJob( channel );
+                channel = other;
             }
+            return channel;
         }
 
-    protected:
-        MPISystemAgent() {}
+        /** Return the number of jobs (channels) whose slaves are still in use. */
+        unsigned int getNumberOfUsableChannels() const
+        {
+            return this->getJobScheduler()->getNumberOfJobs() - this->m_BlacklistedChannels.size();
+        }
+
+        /**
+        Return the ranks of the slaves that have hung or died, which cannot be told to exit
+        and would block MPI_Finalize().
+        */
+        void getLostWorkerRanks( std::set<RankType>& ranks )
+        {
+            ranks.clear();
+            for ( std::set<RankType>::const_iterator i = this->m_LostChannels.begin(); i != this->m_LostChannels.end(); i++ )
+            {
+                ranks.insert( this->getChannel( *i )->getWorkerRank() );
+            }
+        }
+
+        /** Return the agent of a job (channel) of the scheduler. */
+        Self* getChannel( RankType channel )
+        {
+            Self* agent = dynamic_cast<Self*>( this->getJobScheduler()->getJob( channel ) );
+            if ( agent == 0 )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "getChannel(): job " << channel << " is not a system agent" << End;
+            }
+            return agent;
+        }
+
+        /** Start the computation of a pending evaluation on an acquired channel. */
+        void dispatchEvaluation( EvaluationType* evaluation, RankType channel )
+        {
+            DataType* data = evaluation->getData();
+            int id = data->m_ExampleId;
+
+            DataType::Pointer copy;
+            std::set<int>& examples = this->m_ChannelExamples[channel];
+            if ( id >= 0 && examples.count( id ) )
+            {
+                // the slave already holds this training example, so only send its ID and the parameters
+                copy = DataType::New();
+                copy->m_ExampleId = id;
+                copy->m_OpId = MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID;
+            }
+            else
+            {
+                // the job of the channel works on its own copy of the training example, such that
+                // the same example can be evaluated under different parameters at the same time
+                copy = data->clone();
+                copy->m_OpId = MPISystemParametersTunerContext::TAG_SPT_EVALUATE;
+                if ( id >= 0 ) examples.insert( id );
+            }
+            copy->m_Rank = channel;
+            copy->m_Parameters = evaluation->getParameters();
+            copy->m_Fidelity = evaluation->getFidelity();
+            if ( id >= 0 ) this->m_ExampleChannels[id] = channel;
+
+            SchedulerType* scheduler = this->getJobScheduler();
+            scheduler->getJob( channel )->setData( copy );
+            scheduler->startJob( channel );
+
+            // just post the requests to the slave, will return right away
+            if ( !this->m_ProgressEngine )
+            {
+                this->m_ProgressEngine = MPIProgressEngine::New();
+            }
+            this->getChannel( channel )->startEvaluation( this->m_ProgressEngine );
+
+            evaluation->setChannel( channel );
+            evaluation->setStartTime( this->m_Clock->GetTimeInSeconds() );
+        }
+
+        /** Start the pending evaluations that failed before on the channels not in use, if any. */
+        void dispatchFailedEvaluations()
+        {
+            for ( EvaluationList::iterator i = this->m_PendingEvaluations.begin(); i != this->m_PendingEvaluations.end(); i++ )
+            {
+                if ( (*i)->getChannel() >= 0 ) continue;
+
+                if ( this->getNumberOfUsableChannels() == 0 )
+                {
+                    getSystemLogger() << StartFatal(this->GetNameOfClass()) << "dispatchFailedEvaluations(): no slave left to run the evaluations" << End;
+                }
+
+                RankType channel = this->tryAcquireChannel( -1, (*i)->getFailedChannel() );
+                if ( channel < 0 ) break;
+
+                this->dispatchEvaluation( *i, channel );
+            }
+        }
+
+        /**
+        Drive the outstanding requests until the first slave has finished its computation,
+        and collect the score of its evaluation. The failed and timed-out evaluations found in the
+        meantime are started again on other slaves, or given the failure score.
+        */
+        void collectAnyEvaluation()
+        {
+            while ( true )
+            {
+                this->dispatchFailedEvaluations();
+
+                double now = this->m_Clock->GetTimeInSeconds();
+                for ( EvaluationList::iterator i = this->m_PendingEvaluations.begin(); i != this->m_PendingEvaluations.end(); i++ )
+                {
+                    EvaluationType* evaluation = *i;
+                    if ( evaluation->getChannel() < 0 ) continue;
+
+                    ChannelState state = this->getChannel( evaluation->getChannel() )->getChannelState();
+                    if ( state == CHANNEL_DONE )
+                    {
+                        this->finishEvaluation( i );
+                        return;
+                    }
+
+                    // a slave that has stopped a cancelled evaluation on request has not failed
+                    if ( state == CHANNEL_FAILED && evaluation->isCancelled() && !this->getChannel( evaluation->getChannel() )->isWorkerLost() )
+                    {
+                        if ( this->m_ProgressEngine->getNumberOfRequests( this->getChannel( evaluation->getChannel() ) ) == 0 )
+                        {
+                            this->finishEvaluation( i );
+                            return;
+                        }
+                        state = CHANNEL_COLLECTING;
+                    }
+
+                    bool timedout = ( this->m_EvaluationTimeout > 0 && now - evaluation->getStartTime() > this->m_EvaluationTimeout );
+                    if ( state == CHANNEL_FAILED || timedout )
+                    {
+                        if ( this->failEvaluation( evaluation, timedout ) )
+                        {
+                            this->m_PendingEvaluations.erase( i );
+                            return;
+                        }
+                    }
+                }
+
+                if ( !this->m_ProgressEngine || this->m_ProgressEngine->getNumberOfRequests() == 0 )
+                {
+                    if ( this->m_PendingEvaluations.empty() || this->getNumberOfUsableChannels() == 0 )
+                    {
+                        getSystemLogger() << StartFatal(this->GetNameOfClass()) << "collectAnyEvaluation(): no evaluation in progress" << End;
+                    }
+                    continue;
+                }
+
+                // without a timeout, block until some request completes; otherwise poll
+                if ( this->m_EvaluationTimeout <= 0 )
+                {
+                    this->m_ProgressEngine->progress( true );
+                }
+                else if ( this->m_ProgressEngine->progress( false ) == 0 )
+                {
+                    itksys::SystemTools::Delay( 1 );
+                }
+            }
+        }
+
+        /** Collect the score of an evaluation whose slave has finished, and free the slave. */
+        void finishEvaluation( EvaluationList::iterator i )
+        {
+            SchedulerType* scheduler = this->getJobScheduler();
+
+            EvaluationPointer evaluation = *i;
+            this->m_PendingEvaluations.erase( i );
+
+            RankType channel = evaluation->getChannel();
+            Self* agent = this->getChannel( channel );
+            agent->resetChannelState();
+            scheduler->endJob( channel );
+
+            evaluation->setScore( agent->getData()->m_Score );
+            evaluation->setChannel( -1 );
+            if ( !evaluation->isCancelled() )
+            {
+                evaluation->setState( EvaluationType::EVALUATION_DONE );
+            }
+
+            this->m_ChannelFailures[channel] = 0;
+
+            // update the time estimate of the training example, and the statistics of the slave,
+            // unless the evaluation has been stopped early
+            if ( !evaluation->isCancelled() )
+            {
+                double actual = this->m_Clock->GetTimeInSeconds() - evaluation->getStartTime();
+                const DataType* data = evaluation->getData();
+                double fidelity = evaluation->getFidelity();
+                double expected = this->getEstimatedEvaluationTime( data );
+
+                // the estimates are kept for full-fidelity scores, assuming the time is proportional to the fidelity
+                double full = actual / fidelity;
+                this->m_EstimatedTimes[data] = ( expected > 0 ? expected + 0.3 * ( full - expected ) : full );
+
+                scheduler->recordJobTime( channel, expected * fidelity, actual );
+            }
+            scheduler->releaseJob( channel );
+        }
+
+        /**
+        Give up the computation of an evaluation on its channel, and stop using the slave if it has hung
+        or failed too often. Return true if the evaluation is done with the failure score; otherwise it
+        remains pending, to be started again on another slave.
+        */
+        bool failEvaluation( EvaluationType* evaluation, bool timedout )
+        {
+            SchedulerType* scheduler = this->getJobScheduler();
+
+            RankType channel = evaluation->getChannel();
+            Self* agent = this->getChannel( channel );
+            RankType wrank = agent->getWorkerRank();
+            bool lost = ( timedout || agent->isWorkerLost() );
+
+            // drop the outstanding requests, e.g. the receive of a score that will never come
+            this->m_ProgressEngine->cancel( agent );
+            agent->resetChannelState();
+            scheduler->endJob( channel );
+
+            // after a failure, the slave may not hold the training example anymore
+            this->m_ChannelExamples[channel].erase( evaluation->getData()->m_ExampleId );
+
+            unsigned int failures = ++this->m_ChannelFailures[channel];
+            if ( lost || failures >= this->m_MaximumNumberOfFailuresPerSlave )
+            {
+                this->m_BlacklistedChannels.insert( channel );
+                if ( lost ) this->m_LostChannels.insert( channel );
+                this->m_ChannelExamples.erase( channel );
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "failEvaluation(): worker " << wrank << ( timedout ? " timed out" : lost ? " cannot be reached" : " failed too often" ) << ", no longer used (" << this->getNumberOfUsableChannels() << " workers left)" << End;
+            }
+            else
+            {
+                scheduler->releaseJob( channel );
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "failEvaluation(): score computation failed on worker " << wrank << End;
+            }
+
+            evaluation->setChannel( -1 );
+            evaluation->setFailedChannel( channel );
+            evaluation->setNumberOfFailures( evaluation->getNumberOfFailures() + 1 );
+
+            // nobody waits for the score of a cancelled evaluation, so do not try again
+            if ( evaluation->isCancelled() )
+            {
+                return true;
+            }
+
+            if ( evaluation->getNumberOfFailures() <= this->m_MaximumNumberOfRetries )
+            {
+                return false;
+            }
+
+            if ( !this->m_UseFailureScore )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "failEvaluation(): evaluation of training example " << evaluation->getData()->m_ExampleId << " failed " << evaluation->getNumberOfFailures() << " times with parameters " << evaluation->getParameters() << End;
+            }
+
+            getSystemLogger() << StartWarning(this->GetNameOfClass()) << "failEvaluation(): evaluation of training example " << evaluation->getData()->m_ExampleId << " failed " << evaluation->getNumberOfFailures() << " times, scored " << this->m_FailureScore << End;
+            evaluation->setScore( this->m_FailureScore );
+            evaluation->setState( EvaluationType::EVALUATION_DONE );
+            return true;
+        }
 
     private:
         MPISystemAgent( const Self & ); // purposely not implemented
         MPISystemAgent& operator=( const Self & ); // purposely not implemented
 
         mutable SchedulerType::Pointer m_JobScheduler;
+
+        /** Evaluations in progress, in submission order, including the failed ones waiting to be started again. */
+        EvaluationList m_PendingEvaluations;
+
+        double m_EvaluationTimeout;
+        unsigned int m_MaximumNumberOfRetries;
+        unsigned int m_MaximumNumberOfFailuresPerSlave;
+        MeasureType m_FailureScore;
+        bool m_UseFailureScore;
+
+        /** Consecutive failures of the slave of each channel, channels no longer used, and those of them whose slaves hung or died. */
+        std::map<RankType,unsigned int> m_ChannelFailures;
+        std::set<RankType> m_BlacklistedChannels;
+        std::set<RankType> m_LostChannels;
+
+        /** Moving averages of the evaluation times of the training examples. */
+        typedef std::map<const DataType*,double> TimeMap;
+        TimeMap m_EstimatedTimes;
+
+        itk::RealTimeClock::Pointer m_Clock;
+
+        /** Training examples held by the slave of each channel, and channel that evaluated each example last. */
+        typedef std::map<RankType,std::set<int> > ExampleSetMap;
+        ExampleSetMap m_ChannelExamples;
+        typedef std::map<int,RankType> AffinityMap;
+        AffinityMap m_ExampleChannels;
+
+        /** Evaluation started by the last call to updatePerformanceScore(). */
+        EvaluationPointer m_LastEvaluation;
+
+        /** Buffer reused for all the messages sent through this channel. */
+        StreamBuffer m_Buffer;
+
+        /** Identifiers of the non-blocking requests posted by a channel. */
+        enum { REQUEST_COMMAND=0, REQUEST_DATA, REQUEST_ACK, REQUEST_STATUS, REQUEST_SCORE, REQUEST_CANCEL };
+
+        /** Engine that drives the non-blocking requests, owned by the tuner-side agent and shared with its channels. */
+        MPIProgressEngine::Pointer m_ProgressEngine;
+
+        /** State of the evaluation in progress on this channel, and receive buffer of its score. */
+        ChannelState m_ChannelState;
+        double m_ReceivedScore;
+        bool m_ScoreReceived;
+
+        /** Variable to indicate that MPI has returned an error for a request to the slave of this channel. */
+        bool m_WorkerLost;
     };
 
 } // namespace szi
@@ -12,7 +12,20 @@ namespace szi
         {
             TAG_SPT_BASE = 100,
             TAG_SPT_UPDATE_SCORE,
-            TAG_SPT_GET_SCORE
+            TAG_SPT_GET_SCORE,
+            TAG_SPT_UPDATE_SCORE_BY_ID,
+            /**
+            Fused update-and-score requests: the slave receives the training example (or its ID) with the
+            parameters, and pushes the score back as soon as it is computed, in a single message tagged
+            TAG_OK, or an empty message tagged TAG_FAIL. No TAG_SPT_GET_SCORE request follows.
+            */
+            TAG_SPT_EVALUATE,
+            TAG_SPT_EVALUATE_BY_ID,
+            /**
+            Request to stop the evaluation in progress, polled by the slave while it computes the score; the
+            slave then replies TAG_FAIL. A request arriving after the score has been sent is ignored.
+            */
+            TAG_SPT_CANCEL
         };
     };
 
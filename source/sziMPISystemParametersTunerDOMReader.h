@@ -53,6 +53,46 @@ namespace szi
                 this->SetOutput( output );
             }
 
+            // read the fault tolerance settings
+
+            itk::FancyString s;
+
+            s = inputdom->GetAttribute( "EvaluationTimeout" );
+            if ( s != "" )
+            {
+                double t = 0;
+                s >> t;
+                output->setEvaluationTimeout( t );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateMaster(): EvaluationTimeout = " << t << End;
+            }
+
+            s = inputdom->GetAttribute( "MaximumNumberOfRetries" );
+            if ( s != "" )
+            {
+                unsigned int n = 0;
+                s >> n;
+                output->setMaximumNumberOfRetries( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateMaster(): MaximumNumberOfRetries = " << n << End;
+            }
+
+            s = inputdom->GetAttribute( "MaximumNumberOfFailuresPerSlave" );
+            if ( s != "" )
+            {
+                unsigned int n = 0;
+                s >> n;
+                output->setMaximumNumberOfFailuresPerSlave( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateMaster(): MaximumNumberOfFailuresPerSlave = " << n << End;
+            }
+
+            s = inputdom->GetAttribute( "FailureScore" );
+            if ( s != "" )
+            {
+                double score = 0;
+                s >> score;
+                output->setFailureScore( score );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateMaster(): FailureScore = " << score << End;
+            }
+
             const DOMNodeType* node = 0;
 
             // read the tuner
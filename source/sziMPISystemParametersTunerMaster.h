@@ -2,11 +2,14 @@
 #define _sziMPISystemParametersTunerMaster_h_
 
 #include <itkObject.h>
+#include <itkRealTimeClock.h>
 #include "sziMPIWorker.h"
 #include "sziSystemParametersTuner.h"
 #include "sziMPISystemAgent.h"
 #include "sziMPIJobScheduler.h"
 
+#include <ctime>
+
 namespace szi
 {
 
@@ -40,6 +43,35 @@ namespace szi
         SchedulerType* getJobScheduler() { return this->m_JobScheduler; }
         const SchedulerType* getJobScheduler() const { return this->m_JobScheduler; }
 
+        /** Set/get the time (in seconds) after which a slave that has not finished an evaluation is considered hung (0 to wait forever). */
+        virtual void setEvaluationTimeout( double t ) { this->m_EvaluationTimeout = t; }
+        double getEvaluationTimeout() const { return this->m_EvaluationTimeout; }
+
+        /** Set/get the number of times a failed evaluation is retried on another slave. */
+        virtual void setMaximumNumberOfRetries( unsigned int n ) { this->m_MaximumNumberOfRetries = n; }
+        unsigned int getMaximumNumberOfRetries() const { return this->m_MaximumNumberOfRetries; }
+
+        /** Set/get the number of consecutive failures after which a slave is no longer used. */
+        virtual void setMaximumNumberOfFailuresPerSlave( unsigned int n ) { this->m_MaximumNumberOfFailuresPerSlave = n; }
+        unsigned int getMaximumNumberOfFailuresPerSlave() const { return this->m_MaximumNumberOfFailuresPerSlave; }
+
+        /** Set the score of an evaluation that fails after all the retries, instead of aborting the tuning. */
+        virtual void setFailureScore( double score ) { this->m_FailureScore = score; this->m_UseFailureScore = true; }
+        double getFailureScore() const { return this->m_FailureScore; }
+
+        /** Save the progress of the tuning to the file, unless another file was specified for the tuner. */
+        virtual void setCheckpoint( const std::string& filename, bool resume )
+        {
+            TunerType* tuner = this->getTuner();
+            if ( tuner == 0 ) return;
+
+            if ( tuner->getCheckpointFileName().empty() )
+            {
+                tuner->setCheckpointFileName( filename );
+            }
+            tuner->setResume( resume );
+        }
+
         virtual void initialize()
         {
         	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): =====start=====" << End;
@@ -65,17 +97,31 @@ namespace szi
                 this->setJobScheduler( scheduler );
             }
 
-            // Get the data (training examples) from the tuner for subsequent job agents creation.
+            // Number the training examples, such that slaves can keep them and refer to them by ID.
             typedef TunerType::DataType DataType;
-            DataType* data = tuner->getData();
+            DataType* examples = tuner->getData();
+            for ( unsigned int i = 0; i < examples->size(); i++ )
+            {
+                if ( examples->at(i) ) examples->at(i)->m_ExampleId = (int)i;
+            }
 
-            // Create and add all job agents on the master side that will run on slaves.
+            // Create and add one job agent per slave on the master side. Each of them is a channel
+            // to a slave, and any training example can be sent through any channel for evaluation,
+            // so that several evaluations of the same example (e.g. for a whole swarm of particles)
+            // may be in progress at the same time.
             typedef MPISystemAgent JobType;
-            unsigned int njobs = data->size();
+            typedef JobType::DataType JobDataType;
+            unsigned int njobs = MPIContext::getNumberOfWorkers() - 1;
+            if ( njobs == 0 )
+            {
+            	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "initialize(): no slave worker available" << End;
+            }
             for ( unsigned int i = 0; i < njobs; i++ )
             {
                 JobType::Pointer job = JobType::New();
-                job->setData( data->at(i) );
+                // placeholder data, replaced by a copy of the training example at each evaluation
+                JobDataType::Pointer data = JobDataType::New();
+                job->setData( data );
                 job->setRank( (RankType)i );
                 scheduler->addJob( (JobType*)job );
             }
@@ -96,8 +142,14 @@ namespace szi
             agent->setJobScheduler( scheduler );
             // The agent will have the same tunable parameters as the one it represents.
             agent->setTunableParameters( system->getTunableParameters() );
+            // The agent will retry the evaluations that fail or hang on other slaves.
+            agent->setEvaluationTimeout( this->m_EvaluationTimeout );
+            agent->setMaximumNumberOfRetries( this->m_MaximumNumberOfRetries );
+            agent->setMaximumNumberOfFailuresPerSlave( this->m_MaximumNumberOfFailuresPerSlave );
+            if ( this->m_UseFailureScore ) agent->setFailureScore( this->m_FailureScore );
             // Replace the original system with this agent.
             tuner->setSystem( agent );
+            this->m_Agent = agent;
 
             tuner->initialize();
 
@@ -115,6 +167,11 @@ namespace szi
 				getSystemLogger() << StartFatal(this->GetNameOfClass()) << "execute(): worker not initialized" << End;
 			}
 
+            // measure the CPU time used by the master process (all of its threads) against the wall time
+            itk::RealTimeClock::Pointer clock = itk::RealTimeClock::New();
+            itk::RealTimeClock::TimeStampType wallstart = clock->GetTimeInSeconds();
+            std::clock_t cpustart = std::clock();
+
             this->getJobScheduler()->execute();
             //
             try
@@ -127,23 +184,49 @@ namespace szi
             //
             this->getJobScheduler()->terminate();
 
+            double cputime = (double)( std::clock() - cpustart ) / CLOCKS_PER_SEC;
+            double walltime = clock->GetTimeInSeconds() - wallstart;
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "execute(): master CPU time = " << cputime << " s, wall time = " << walltime << " s, CPU use = " << ( walltime > 0 ? 100.0 * cputime / walltime : 0.0 ) << "%" << End;
+
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "execute(): -----e-n-d-----" << End;
         }
 
         virtual void finalize()
         {
-        	MPIContext::terminateAllSlaves();
+            // the slaves that hung or died cannot be told to exit
+            std::set<RankType> lost;
+            if ( this->m_Agent ) this->m_Agent->getLostWorkerRanks( lost );
+            if ( !lost.empty() )
+            {
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "finalize(): " << lost.size() << " workers hung or died, the job will be aborted" << End;
+            }
+            this->m_AbortRequired = !lost.empty();
+
+        	MPIContext::terminateAllSlaves( lost );
         	MPIWorker::finalize();
         }
 
+        virtual bool getAbortRequired() const { return this->m_AbortRequired; }
+
     protected:
-        MPISystemParametersTunerMaster() {}
+        MPISystemParametersTunerMaster() : m_EvaluationTimeout(0), m_MaximumNumberOfRetries(2), m_MaximumNumberOfFailuresPerSlave(3),
+                                           m_FailureScore(0), m_UseFailureScore(false), m_AbortRequired(false) {}
 
     private:
         MPISystemParametersTunerMaster( const Self & ); // Purposely not implemented.
         MPISystemParametersTunerMaster& operator=( const Self & ); // Purposely not implemented.
 
         SchedulerType::Pointer m_JobScheduler;
+
+        double m_EvaluationTimeout;
+        unsigned int m_MaximumNumberOfRetries;
+        unsigned int m_MaximumNumberOfFailuresPerSlave;
+        double m_FailureScore;
+        bool m_UseFailureScore;
+
+        /** Agent replacing the system of the tuner, which knows the slaves that hung or died. */
+        MPISystemAgent::Pointer m_Agent;
+        bool m_AbortRequired;
     };
 
 } // namespace szi
@@ -5,13 +5,17 @@
 #include "sziMPIWorker.h"
 #include "sziSystem.h"
 #include "sziMPISystemParametersTunerContext.h"
+#include "sziMPICancellationToken.h"
+
+#include <map>
 
 namespace szi
 {
 
     /**
     Slave worker that provides service to the master. It repeatedly listens to messages from the master,
-    take the actions, and returns the results to the master.
+    take the actions, and returns the results to the master. While the score of a training example is
+    computed, the master may request to stop it, which the system polls for through its cancellation token.
     */
     class MPISystemParametersTunerSlave : public itk::Object, public MPIWorker
     {
@@ -46,6 +50,10 @@ namespace szi
             }
             system->initialize();
 
+            // the master requests to stop a fused evaluation by a message to be polled for while it runs
+            this->m_CancellationToken->setSource( 0, MPISystemParametersTunerContext::TAG_SPT_CANCEL );
+            system->setCancellationToken( this->m_CancellationToken );
+
             MPIWorker::initialize();
 
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): -----e-n-d-----" << End;
@@ -81,30 +89,34 @@ namespace szi
                     break;
                 }
 
-                else if ( tag == MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE )
+                else if ( tag == MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE ||
+                          tag == MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE_BY_ID ||
+                          tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE ||
+                          tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID )
                 {
-                    SystemDataType* data = system->getData();
-
-                    // receive a SystemData from the master
-                    MPIContext::receive( (Streamable&)(*data), 0, MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE );
-
-                    try
+                    SystemDataType::Pointer data = this->receiveExample( tag );
+                    if ( !data )
                     {
-						// associate the data with the system
-						system->setData( data );
-						// update the values for tunable parameters
-						system->setTunableParameters( data->m_Parameters );
-						// compute the performance score
-						system->updatePerformanceScore();
+                    	MPIContext::send( 0, MPIContext::TAG_FAIL );
+                    	continue;
+                    }
 
-						MPIContext::send( 0, MPIContext::TAG_OK );
+                    if ( tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE ||
+                         tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID )
+                    {
+                        this->evaluate( data );
                     }
-                    catch (...)
+                    else
                     {
-                    	MPIContext::send( 0, MPIContext::TAG_FAIL );
+                        this->updateScore( data );
                     }
                 }
 
+                else if ( tag == MPISystemParametersTunerContext::TAG_SPT_CANCEL )
+                {
+                    // the score was sent before the request arrived, nothing left to stop
+                }
+
                 else if ( tag == MPISystemParametersTunerContext::TAG_SPT_GET_SCORE )
                 {
                 	try
@@ -132,11 +144,112 @@ namespace szi
         }
 
     protected:
-        MPISystemParametersTunerSlave() {}
+        MPISystemParametersTunerSlave()
+        {
+            this->m_CancellationToken = MPICancellationToken::New();
+        }
+
+        /**
+        Receive a training example and the parameters to evaluate from the master. If only the ID of the
+        example is sent, the example previously received is used; return null if it is unknown.
+        */
+        SystemDataType::Pointer receiveExample( int tag )
+        {
+            if ( tag == MPISystemParametersTunerContext::TAG_SPT_UPDATE_SCORE_BY_ID ||
+                 tag == MPISystemParametersTunerContext::TAG_SPT_EVALUATE_BY_ID )
+            {
+                // receive the ID of a training example and the parameters from the master
+                SystemDataType::Pointer message = SystemDataType::New();
+                MPIContext::receive( (Streamable&)(*message), 0, tag, this->m_Buffer );
+
+                ExampleMap::iterator i = this->m_Examples.find( message->m_ExampleId );
+                if ( i == this->m_Examples.end() )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "receiveExample(): unknown training example " << message->m_ExampleId << End;
+                	return 0;
+                }
+
+                i->second->m_Parameters = message->m_Parameters;
+                i->second->m_Fidelity = message->m_Fidelity;
+                return i->second;
+            }
+
+            // receive a SystemData from the master, into a new object of the same type as the system's data
+            SystemDataType::Pointer data = this->getSystem()->getData()->clone();
+            MPIContext::receive( (Streamable&)(*data), 0, tag, this->m_Buffer );
+
+            // keep the training example, such that the master can later refer to it by ID
+            if ( data->m_ExampleId >= 0 )
+            {
+                this->m_Examples[data->m_ExampleId] = data;
+            }
+            return data;
+        }
+
+        /** Compute the performance score of a training example, and send it to the master right away. */
+        void evaluate( SystemDataType* data )
+        {
+            SystemType* system = this->getSystem();
+
+            this->m_CancellationToken->reset();
+
+            try
+            {
+                system->setData( data );
+                system->setTunableParameters( data->m_Parameters );
+                system->setFidelity( data->m_Fidelity );
+                system->updatePerformanceScore();
+
+                double score = system->getPerformanceScore();
+                MPIContext::send( score, 0, MPIContext::TAG_OK );
+            }
+            catch (...)
+            {
+                if ( this->m_CancellationToken->isCancelled() )
+                {
+                	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "evaluate(): evaluation of training example " << data->m_ExampleId << " cancelled by the master" << End;
+                }
+                MPIContext::send( 0, MPIContext::TAG_FAIL );
+            }
+        }
+
+        /** Compute the performance score of a training example, and acknowledge the master. */
+        void updateScore( SystemDataType* data )
+        {
+            SystemType* system = this->getSystem();
+
+            this->m_CancellationToken->reset();
+
+            try
+            {
+                // associate the data with the system
+                system->setData( data );
+                // update the values for tunable parameters
+                system->setTunableParameters( data->m_Parameters );
+                system->setFidelity( data->m_Fidelity );
+                // compute the performance score
+                system->updatePerformanceScore();
+
+                MPIContext::send( 0, MPIContext::TAG_OK );
+            }
+            catch (...)
+            {
+                MPIContext::send( 0, MPIContext::TAG_FAIL );
+            }
+        }
 
     private:
         MPISystemParametersTunerSlave( const Self & ); // Purposely not implemented.
         MPISystemParametersTunerSlave& operator=( const Self & ); // Purposely not implemented.
+
+        /** Buffer reused for all the messages received from the master. */
+        StreamBuffer m_Buffer;
+
+        /** Training examples received from the master, by ID. */
+        typedef std::map<int,SystemDataType::Pointer> ExampleMap;
+        ExampleMap m_Examples;
+
+        MPICancellationToken::Pointer m_CancellationToken;
     };
 
 } // namespace szi
@@ -9,6 +9,8 @@
 #include "sziMPIContext.h"
 #include "sziLogService.h"
 
+#include <string>
+
 namespace szi
 {
 
@@ -52,6 +54,18 @@ namespace szi
         JobType* getJob() { return this->m_Job; }
         const JobType* getJob() const { return this->m_Job; }
 
+        /**
+        Set the file the progress of the job is saved to, and whether the job resumes from it.
+        It is ignored by workers whose jobs cannot be resumed.
+        */
+        virtual void setCheckpoint( const std::string& filename, bool resume ) {}
+
+        /**
+        Return true if MPI must be aborted rather than finalized after this worker has been finalized,
+        e.g. because some workers have hung or died and would block MPI_Finalize().
+        */
+        virtual bool getAbortRequired() const { return false; }
+
         /**
         Execute the associated job, and set the corresponding states
         for this worker as well as the associated job.
@@ -5,6 +5,9 @@
 #include "sziMPIWorker.h"
 #include "sziMPIWorkerDOMReader.h"
 
+#include <cstdlib>
+#include <string>
+
 namespace szi
 {
 
@@ -38,24 +41,44 @@ namespace szi
                 return;
             }
 
-            // Initialize MPI.
-            MPI_Init( &argc, &argv );
+            // Initialize MPI. The master drives all its communication from one thread with non-blocking
+            // requests, but the threaded job schedulers call MPI from several threads, so ask for full
+            // thread support and check what the library actually provides.
+            int provided = MPI_THREAD_SINGLE;
+            MPI_Init_thread( &argc, &argv, MPI_THREAD_MULTIPLE, &provided );
 
             // Find out this worker's identity in the default communicator.
             RankType rank = MPIContext::getWorkerRank();
 
+            // The master handles the errors of its communication itself, such that a slave that dies
+            // only fails its evaluation instead of aborting the whole job; the slaves still abort.
+            if ( rank == 0 )
+            {
+                MPI_Comm_set_errhandler( MPI_COMM_WORLD, MPI_ERRORS_RETURN );
+            }
+
             // Store it as an internal state for future reference.
             this->setRank( rank );
 
+            // Find the input XML job file and the options among the arguments.
+            const char* input = 0;
+            bool resume = false;
+            for ( int i = 1; i < argc; i++ )
+            {
+                std::string arg( argv[i] );
+                if ( arg == "--resume" ) resume = true;
+                else if ( input == 0 ) input = argv[i];
+            }
+
             // Check whether an input XML job file has been provided or not.
-            if ( argc < 2 )
+            if ( input == 0 )
             {
                 MPI_Finalize();
                 throw "Input job file is missing!";
             }
 
             // start the system logging
-            itk::FancyString name( argv[1] );
+            itk::FancyString name( input );
             name << ".Worker-" << rank;
  			getSystemLogger().StartLogging( name );
 
@@ -69,8 +92,15 @@ namespace szi
             	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize():   argv[" << i << "] = \"" << argv[i] << "\"" << End;
             }
 
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): MPI thread support is " << MPIContext::getThreadSupportName( provided ) << End;
+            if ( provided < MPI_THREAD_FUNNELED )
+            {
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "initialize(): MPI library provides no thread support, only the main thread may communicate" << End;
+            }
+
             // Store the input XML job file for subsequent job processing.
-            this->m_InputFileName = argv[1];
+            this->m_InputFileName = input;
+            this->m_Resume = resume;
 
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): -----e-n-d-----" << End;
         }
@@ -118,6 +148,11 @@ namespace szi
             // Control will be delegated to the newly created worker, so copy my ID to it.
             worker->setRank( rank );
 
+            // The progress of the job is saved next to the input XML job file, to be resumed with --resume.
+            std::string checkpoint( this->m_InputFileName );
+            checkpoint += ".checkpoint";
+            worker->setCheckpoint( checkpoint, this->m_Resume );
+
             // Pass the control to the newly created worker and start the service.
             // If it is the master, it will send job pieces to the slaves; otherwise,
             // this slave will listen to service requests from the master.
@@ -130,6 +165,7 @@ namespace szi
             {
             }
 			worker->finalize();
+            this->m_AbortRequired = worker->getAbortRequired();
 
             // Log the auditing information.
 			getSystemLogger() << StartInfo(this->GetNameOfClass()) << "execute(): -----e-n-d-----" << End;
@@ -141,8 +177,16 @@ namespace szi
             // Perform house-keeping if this worker has been initialized previously.
             if ( this->m_InputFileName )
             {
-                MPI_Finalize();
                 this->m_InputFileName = 0;
+
+                // MPI_Finalize() would wait for the workers that hung or died
+                if ( this->m_AbortRequired )
+                {
+                    getSystemLogger() << StartWarning(this->GetNameOfClass()) << "finalize(): aborting the job" << End;
+                    getSystemLogger().EndLogging();
+                    MPI_Abort( MPI_COMM_WORLD, EXIT_FAILURE );
+                }
+                MPI_Finalize();
             }
         }
 
@@ -152,7 +196,7 @@ namespace szi
         }
 
     protected:
-        MPIWorkerLauncher() : m_InputFileName(0) {}
+        MPIWorkerLauncher() : m_InputFileName(0), m_Resume(false), m_AbortRequired(false) {}
 
     private:
         MPIWorkerLauncher( const Self & ); // Purposely not implemented.
@@ -163,6 +207,12 @@ namespace szi
         It is also served as a flag to indicate whether the worker is initialized (when !=0) or not (when ==0).
         */
         const char* m_InputFileName;
+
+        /** Variable to indicate that the job resumes from its last checkpoint (the --resume option). */
+        bool m_Resume;
+
+        /** Variable to indicate that MPI must be aborted rather than finalized, see MPIWorker::getAbortRequired(). */
+        bool m_AbortRequired;
     };
 
 } // namespace szi
@@ -8,6 +8,8 @@
 #include "sziAmoebaOptimizerDOMReader.h"
 #include "sziRegularStepGradientDescentOptimizerDOMReader.h"
 #include "sziParticleSwarmOptimizerDOMReader.h"
+#include "sziBayesianOptimizerDOMReader.h"
+#include "sziCMAESOptimizerDOMReader.h"
 
 #include "sziLogService.h"
 
@@ -39,8 +41,8 @@ namespace szi
 
             itk::FancyString tagname = inputdom->GetName();
 
-            // the optimizer type is ExhaustiveOptimizer
-            if ( tagname == "ExhaustiveOptimizer" )
+            // the optimizer type is ExhaustiveOptimizer or BatchExhaustiveOptimizer
+            if ( tagname == "ExhaustiveOptimizer" || tagname == "BatchExhaustiveOptimizer" )
             {
                 typedef ExhaustiveOptimizerDOMReader ReaderType;
                 typedef ReaderType::OutputType RealOutputType;
@@ -103,7 +105,7 @@ namespace szi
             }
 
             // the optimizer type is ParticleSwarmOptimizer
-            else if ( tagname.MatchWith("ParticleSwarmOptimizer") )
+            else if ( tagname.MatchWith("ParticleSwarmOptimizer") || tagname.MatchWith("BatchParticleSwarmOptimizer") )
             {
                 typedef ParticleSwarmOptimizerDOMReader ReaderType;
                 typedef ReaderType::OutputType RealOutputType;
@@ -123,6 +125,48 @@ namespace szi
                 this->SetOutput( output );
             }
 
+            // the optimizer type is CMAESOptimizer
+            else if ( tagname == "CMAESOptimizer" )
+            {
+                typedef CMAESOptimizerDOMReader ReaderType;
+                typedef ReaderType::OutputType RealOutputType;
+                //
+                OutputType* o = this->GetOutput();
+                RealOutputType* output = dynamic_cast<RealOutputType*>( o );
+                if ( o && output == 0 )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): The user-specified output is invalid and will be ignored!" << End;
+                }
+                //
+                ReaderType::Pointer reader = ReaderType::New();
+                reader->SetOutput( output );
+                reader->Update( inputdom );
+                output = reader->GetOutput();
+                //
+                this->SetOutput( output );
+            }
+
+            // the optimizer type is BayesianOptimizer
+            else if ( tagname == "BayesianOptimizer" )
+            {
+                typedef BayesianOptimizerDOMReader ReaderType;
+                typedef ReaderType::OutputType RealOutputType;
+                //
+                OutputType* o = this->GetOutput();
+                RealOutputType* output = dynamic_cast<RealOutputType*>( o );
+                if ( o && output == 0 )
+                {
+                	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): The user-specified output is invalid and will be ignored!" << End;
+                }
+                //
+                ReaderType::Pointer reader = ReaderType::New();
+                reader->SetOutput( output );
+                reader->Update( inputdom );
+                output = reader->GetOutput();
+                //
+                this->SetOutput( output );
+            }
+
             // the optimizer type is not supported
             else
             {
@@ -0,0 +1,119 @@
+#ifndef _sziOptimizerValueTracker_h_
+#define _sziOptimizerValueTracker_h_
+
+#include <itkSingleValuedNonLinearOptimizer.h>
+#include <itkSingleValuedNonLinearVnlOptimizer.h>
+#include <itkRegularStepGradientDescentBaseOptimizer.h>
+#include <itkGradientDescentOptimizer.h>
+#include <itkParticleSwarmOptimizerBase.h>
+#include <itkExhaustiveOptimizer.h>
+
+#include "sziBatchExhaustiveOptimizer.h"
+#include "sziBayesianOptimizer.h"
+#include "sziCMAESOptimizer.h"
+
+namespace szi
+{
+
+    /**
+    Class to be used by iteration observers to get the value of the cost function that the optimizer
+    has computed last, together with the position it was computed at, instead of evaluating the cost
+    function again at the current position, which can be as expensive as the iteration itself.
+    Gradient descent optimizers compute the value before taking a step, so the value belongs to the
+    position of the previous iteration, which is tracked here; call reset() before each optimization.
+    */
+    class OptimizerValueTracker
+    {
+    public:
+        typedef itk::SingleValuedNonLinearOptimizer OptimizerType;
+        typedef OptimizerType::ParametersType ParametersType;
+        typedef OptimizerType::MeasureType MeasureType;
+
+        OptimizerValueTracker() {}
+
+        /** Forget the position of the previous iteration. */
+        void reset() { this->m_PreviousPosition.SetSize( 0 ); }
+
+        /**
+        Get the last value computed by the optimizer and its position, to be called once per iteration event.
+        Return false if the optimizer does not expose it, in which case nothing is changed.
+        */
+        bool update( const OptimizerType* optimizer, ParametersType& position, MeasureType& value )
+        {
+            typedef itk::RegularStepGradientDescentBaseOptimizer RSGDOptimizerType;
+            typedef itk::GradientDescentOptimizer GDOptimizerType;
+            typedef itk::ParticleSwarmOptimizerBase PSOptimizerType;
+            typedef itk::SingleValuedNonLinearVnlOptimizer VnlOptimizerType;
+
+            if ( const RSGDOptimizerType* o = dynamic_cast<const RSGDOptimizerType*>( optimizer ) )
+            {
+                value = o->GetValue();
+                position = this->stepFrom( optimizer );
+                return true;
+            }
+            if ( const GDOptimizerType* o = dynamic_cast<const GDOptimizerType*>( optimizer ) )
+            {
+                value = o->GetValue();
+                position = this->stepFrom( optimizer );
+                return true;
+            }
+            if ( const PSOptimizerType* o = dynamic_cast<const PSOptimizerType*>( optimizer ) )
+            {
+                // the current position is the best one found so far
+                value = o->GetValue();
+                position = o->GetCurrentPosition();
+                return true;
+            }
+            if ( const BatchExhaustiveOptimizer* o = dynamic_cast<const BatchExhaustiveOptimizer*>( optimizer ) )
+            {
+                value = o->getBestValue();
+                position = o->getBestPosition();
+                return true;
+            }
+            if ( const CMAESOptimizer* o = dynamic_cast<const CMAESOptimizer*>( optimizer ) )
+            {
+                value = o->getBestValue();
+                position = o->getBestPosition();
+                return true;
+            }
+            if ( const BayesianOptimizer* o = dynamic_cast<const BayesianOptimizer*>( optimizer ) )
+            {
+                value = o->getBestValue();
+                position = o->getBestPosition();
+                return true;
+            }
+            if ( const itk::ExhaustiveOptimizer* o = dynamic_cast<const itk::ExhaustiveOptimizer*>( optimizer ) )
+            {
+                value = o->GetCurrentValue();
+                position = o->GetCurrentPosition();
+                return true;
+            }
+            if ( const VnlOptimizerType* o = dynamic_cast<const VnlOptimizerType*>( optimizer ) )
+            {
+                value = o->GetCachedValue();
+                position = o->GetCachedCurrentPosition();
+                return true;
+            }
+            return false;
+        }
+
+    protected:
+        /** Return the position before the step just taken by the optimizer, and remember the current one. */
+        ParametersType stepFrom( const OptimizerType* optimizer )
+        {
+            ParametersType previous = this->m_PreviousPosition;
+            if ( previous.GetSize() == 0 )
+            {
+                previous = optimizer->GetInitialPosition();
+            }
+            this->m_PreviousPosition = optimizer->GetCurrentPosition();
+            return previous;
+        }
+
+    private:
+        ParametersType m_PreviousPosition;
+    };
+
+} // namespace szi
+
+#endif // _sziOptimizerValueTracker_h_
@@ -0,0 +1,328 @@
+#ifndef _sziOverlapScorer_h_
+#define _sziOverlapScorer_h_
+
+#include <itkObject.h>
+#include <itkImage.h>
+#include <itkTransform.h>
+#include <itkMatrixOffsetTransformBase.h>
+#include <itkMultiThreader.h>
+#include <itkImageRegionSplitter.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkHausdorffDistanceImageFilter.h>
+#include <itkNumericTraits.h>
+
+#include <cmath>
+#include <vector>
+
+namespace szi
+{
+
+    /**
+    Class to compute the overlap between the foreground of a fixed segmentation and the foreground of a moving
+    segmentation mapped by a transform, as itk::KappaStatisticImageToImageMetric with a nearest neighbour
+    interpolator does, i.e. each fixed pixel of the region is compared with the moving pixel nearest to its
+    transformed position, if inside the moving image. The region is split over several threads, and for the
+    transforms derived from itk::MatrixOffsetTransformBase (affine, similarity, rigid), the moving index is
+    stepped along each row of the fixed image rather than computed for each pixel through physical points.
+    Besides the kappa statistic (equal to the Dice coefficient), the Jaccard coefficient and optionally the
+    Hausdorff distance between the two foregrounds are computed in the same pass.
+    */
+    template < class TImage >
+    class OverlapScorer : public itk::Object
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef OverlapScorer Self;
+        typedef itk::Object Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::OverlapScorer, Object );
+
+        /** User-defined types. */
+        typedef TImage ImageType;
+        typedef typename ImageType::PixelType PixelType;
+        typedef typename ImageType::RegionType RegionType;
+        typedef typename ImageType::IndexType IndexType;
+        typedef typename ImageType::PointType PointType;
+
+        itkStaticConstMacro( ImageDimension, unsigned int, ImageType::ImageDimension );
+
+        typedef itk::Transform<double,ImageDimension,ImageDimension> TransformType;
+        typedef typename TransformType::ParametersType ParametersType;
+        typedef itk::MatrixOffsetTransformBase<double,ImageDimension,ImageDimension> AffineTransformType;
+
+        typedef itk::Image<unsigned char,ImageDimension> MaskType;
+
+        void setFixedImage( const ImageType* image ) { this->m_FixedImage = image; }
+        void setMovingImage( const ImageType* image ) { this->m_MovingImage = image; }
+
+        /** Set the region of the fixed image to score, by default its buffered region. */
+        void setFixedImageRegion( const RegionType& region ) { this->m_FixedImageRegion = region; this->m_UseFixedImageRegion = true; }
+
+        void setForegroundValue( PixelType value ) { this->m_ForegroundValue = value; }
+        PixelType getForegroundValue() const { return this->m_ForegroundValue; }
+
+        void setTransform( TransformType* transform ) { this->m_Transform = transform; }
+
+        /** Set/get the number of threads, by default the global default of ITK. */
+        void setNumberOfThreads( unsigned int n ) { this->m_NumberOfThreads = ( n ? n : 1 ); }
+        unsigned int getNumberOfThreads() const { return this->m_NumberOfThreads; }
+
+        /** Set/get whether the Hausdorff distance is computed too, which is more expensive than the overlap (off by default). */
+        void setComputeHausdorffDistance( bool on ) { this->m_ComputeHausdorffDistance = on; }
+        bool getComputeHausdorffDistance() const { return this->m_ComputeHausdorffDistance; }
+
+        /** Compute the overlap with the transform set to the given parameters. */
+        void compute( const ParametersType& params )
+        {
+            if ( !this->m_FixedImage || !this->m_MovingImage || !this->m_Transform )
+            {
+                throw "Overlap scorer is not set up!";
+            }
+
+            this->m_Transform->SetParameters( params );
+
+            this->m_Region = ( this->m_UseFixedImageRegion ? this->m_FixedImageRegion : this->m_FixedImage->GetBufferedRegion() );
+
+            // the moving continuous index of a fixed index is linear for matrix-offset transforms: m = A f + b
+            const AffineTransformType* affine = dynamic_cast<const AffineTransformType*>( (const TransformType*)this->m_Transform );
+            this->m_Affine = ( affine != 0 );
+            if ( affine )
+            {
+                typedef typename AffineTransformType::MatrixType MatrixType;
+                MatrixType fixedToPhysical = this->m_FixedImage->GetDirection();
+                MatrixType movingToPhysical = this->m_MovingImage->GetDirection();
+                for ( unsigned int i = 0; i < ImageDimension; i++ )
+                {
+                    for ( unsigned int j = 0; j < ImageDimension; j++ )
+                    {
+                        fixedToPhysical[i][j] *= this->m_FixedImage->GetSpacing()[j];
+                        movingToPhysical[i][j] *= this->m_MovingImage->GetSpacing()[j];
+                    }
+                }
+                MatrixType physicalToMoving( movingToPhysical.GetInverse() );
+
+                this->m_IndexMatrix = physicalToMoving * affine->GetMatrix() * fixedToPhysical;
+
+                PointType origin = affine->TransformPoint( this->m_FixedImage->GetOrigin() );
+                for ( unsigned int i = 0; i < ImageDimension; i++ )
+                {
+                    this->m_IndexOffset[i] = 0;
+                    for ( unsigned int j = 0; j < ImageDimension; j++ )
+                    {
+                        this->m_IndexOffset[i] += physicalToMoving[i][j] * ( origin[j] - this->m_MovingImage->GetOrigin()[j] );
+                    }
+                }
+            }
+
+            if ( this->m_ComputeHausdorffDistance )
+            {
+                this->m_FixedMask = this->createMask();
+                this->m_MovingMask = this->createMask();
+            }
+
+            // count the foreground pixels over the splits of the region
+            typedef itk::ImageRegionSplitter<ImageDimension> SplitterType;
+            typename SplitterType::Pointer splitter = SplitterType::New();
+            this->m_NumberOfSplits = splitter->GetNumberOfSplits( this->m_Region, this->m_NumberOfThreads );
+
+            this->m_FixedCounts.assign( this->m_NumberOfSplits, 0 );
+            this->m_MovingCounts.assign( this->m_NumberOfSplits, 0 );
+            this->m_IntersectionCounts.assign( this->m_NumberOfSplits, 0 );
+
+            itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+            threader->SetNumberOfThreads( this->m_NumberOfSplits );
+            threader->SetSingleMethod( thread_callback, (void*)this );
+            threader->SingleMethodExecute();
+
+            unsigned long fixed = 0, moving = 0, intersection = 0;
+            for ( unsigned int t = 0; t < this->m_NumberOfSplits; t++ )
+            {
+                fixed += this->m_FixedCounts[t];
+                moving += this->m_MovingCounts[t];
+                intersection += this->m_IntersectionCounts[t];
+            }
+
+            this->m_Kappa = ( fixed + moving ? 2.0 * intersection / ( fixed + moving ) : 0.0 );
+            this->m_Jaccard = ( fixed + moving - intersection ? (double)intersection / ( fixed + moving - intersection ) : 0.0 );
+
+            this->m_HausdorffDistance = itk::NumericTraits<double>::max();
+            if ( this->m_ComputeHausdorffDistance && fixed && moving )
+            {
+                typedef itk::HausdorffDistanceImageFilter<MaskType,MaskType> HausdorffType;
+                typename HausdorffType::Pointer hausdorff = HausdorffType::New();
+                hausdorff->SetInput1( this->m_FixedMask );
+                hausdorff->SetInput2( this->m_MovingMask );
+                hausdorff->Update();
+                this->m_HausdorffDistance = hausdorff->GetHausdorffDistance();
+            }
+            this->m_FixedMask = 0;
+            this->m_MovingMask = 0;
+        }
+
+        /** Return 1 - kappa, i.e. the complement of the kappa statistic as minimized by the tuning. */
+        double getValue() const { return 1.0 - this->m_Kappa; }
+
+        double getKappa() const { return this->m_Kappa; }
+        double getDice() const { return this->m_Kappa; }
+        double getJaccard() const { return this->m_Jaccard; }
+
+        /** Return the Hausdorff distance (in physical units), or the largest double if not computed or either foreground is empty. */
+        double getHausdorffDistance() const { return this->m_HausdorffDistance; }
+
+    protected:
+        OverlapScorer() : m_UseFixedImageRegion(false), m_ForegroundValue(), m_ComputeHausdorffDistance(false),
+                          m_Affine(false), m_NumberOfSplits(0), m_Kappa(0), m_Jaccard(0), m_HausdorffDistance(0)
+        {
+            this->m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+        }
+
+        static ITK_THREAD_RETURN_TYPE thread_callback( void* arg )
+        {
+            typedef itk::MultiThreader::ThreadInfoStruct ThreaderInfoType;
+            ThreaderInfoType* tinfo = (ThreaderInfoType*)arg;
+
+            Self* self = (Self*)( tinfo->UserData );
+            if ( tinfo->ThreadID < self->m_NumberOfSplits )
+            {
+                typedef itk::ImageRegionSplitter<ImageDimension> SplitterType;
+                typename SplitterType::Pointer splitter = SplitterType::New();
+                self->computeSplit( tinfo->ThreadID, splitter->GetSplit( tinfo->ThreadID, self->m_NumberOfSplits, self->m_Region ) );
+            }
+
+            return ITK_THREAD_RETURN_VALUE;
+        }
+
+        /** Count the foreground pixels of a split of the region, row by row. */
+        void computeSplit( unsigned int t, const RegionType& region )
+        {
+            const ImageType* fixedImage = this->m_FixedImage;
+            const ImageType* movingImage = this->m_MovingImage;
+            const PixelType fg = this->m_ForegroundValue;
+
+            const RegionType& movingRegion = movingImage->GetBufferedRegion();
+            const PixelType* movingBuffer = movingImage->GetBufferPointer();
+            const typename ImageType::OffsetValueType* movingOffsets = movingImage->GetOffsetTable();
+
+            unsigned long fixedCount = 0, movingCount = 0, intersectionCount = 0;
+
+            typedef itk::ImageLinearConstIteratorWithIndex<ImageType> IteratorType;
+            IteratorType it( fixedImage, region );
+            it.SetDirection( 0 );
+            for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+            {
+                // moving continuous index of the first pixel of the row, and its step along the row
+                double cindex[ImageDimension];
+                double step[ImageDimension];
+                if ( this->m_Affine )
+                {
+                    const IndexType& index = it.GetIndex();
+                    for ( unsigned int i = 0; i < ImageDimension; i++ )
+                    {
+                        cindex[i] = this->m_IndexOffset[i];
+                        for ( unsigned int j = 0; j < ImageDimension; j++ ) cindex[i] += this->m_IndexMatrix[i][j] * index[j];
+                        step[i] = this->m_IndexMatrix[i][0];
+                    }
+                }
+
+                for ( it.GoToBeginOfLine(); !it.IsAtEndOfLine(); ++it )
+                {
+                    bool fixedInside = ( it.Get() == fg );
+                    if ( fixedInside ) fixedCount++;
+
+                    if ( !this->m_Affine )
+                    {
+                        PointType point;
+                        fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+                        point = this->m_Transform->TransformPoint( point );
+                        itk::ContinuousIndex<double,ImageDimension> c;
+                        movingImage->TransformPhysicalPointToContinuousIndex( point, c );
+                        for ( unsigned int i = 0; i < ImageDimension; i++ ) cindex[i] = c[i];
+                    }
+
+                    // nearest moving pixel, if inside the moving image
+                    bool movingInside = false;
+                    bool inside = true;
+                    typename ImageType::OffsetValueType offset = 0;
+                    for ( unsigned int i = 0; i < ImageDimension && inside; i++ )
+                    {
+                        long k = (long)std::floor( cindex[i] + 0.5 ) - movingRegion.GetIndex()[i];
+                        inside = ( k >= 0 && k < (long)movingRegion.GetSize()[i] );
+                        offset += ( i == 0 ? k : k * movingOffsets[i] );
+                    }
+                    if ( inside && movingBuffer[offset] == fg )
+                    {
+                        movingInside = true;
+                        movingCount++;
+                        if ( fixedInside ) intersectionCount++;
+                    }
+
+                    if ( this->m_ComputeHausdorffDistance )
+                    {
+                        this->m_FixedMask->SetPixel( it.GetIndex(), fixedInside );
+                        this->m_MovingMask->SetPixel( it.GetIndex(), movingInside );
+                    }
+
+                    if ( this->m_Affine )
+                    {
+                        for ( unsigned int i = 0; i < ImageDimension; i++ ) cindex[i] += step[i];
+                    }
+                }
+            }
+
+            this->m_FixedCounts[t] = fixedCount;
+            this->m_MovingCounts[t] = movingCount;
+            this->m_IntersectionCounts[t] = intersectionCount;
+        }
+
+        /** Create a binary image over the region, in the geometry of the fixed image. */
+        typename MaskType::Pointer createMask() const
+        {
+            typename MaskType::Pointer mask = MaskType::New();
+            mask->SetOrigin( this->m_FixedImage->GetOrigin() );
+            mask->SetSpacing( this->m_FixedImage->GetSpacing() );
+            mask->SetDirection( this->m_FixedImage->GetDirection() );
+            mask->SetRegions( this->m_Region );
+            mask->Allocate();
+            mask->FillBuffer( 0 );
+            return mask;
+        }
+
+    private:
+        OverlapScorer( const Self & ); // purposely not implemented
+        OverlapScorer& operator=( const Self & ); // purposely not implemented
+
+        typename ImageType::ConstPointer m_FixedImage;
+        typename ImageType::ConstPointer m_MovingImage;
+        RegionType m_FixedImageRegion;
+        bool m_UseFixedImageRegion;
+        PixelType m_ForegroundValue;
+        typename TransformType::Pointer m_Transform;
+        unsigned int m_NumberOfThreads;
+        bool m_ComputeHausdorffDistance;
+
+        /** State shared with the threads during compute(). */
+        RegionType m_Region;
+        bool m_Affine;
+        typename AffineTransformType::MatrixType m_IndexMatrix;
+        double m_IndexOffset[ImageDimension];
+        unsigned int m_NumberOfSplits;
+        std::vector<unsigned long> m_FixedCounts;
+        std::vector<unsigned long> m_MovingCounts;
+        std::vector<unsigned long> m_IntersectionCounts;
+        typename MaskType::Pointer m_FixedMask;
+        typename MaskType::Pointer m_MovingMask;
+
+        double m_Kappa;
+        double m_Jaccard;
+        double m_HausdorffDistance;
+    };
+
+} // namespace szi
+
+#endif // _sziOverlapScorer_h_
@@ -4,6 +4,8 @@
 #include <itkDOMReader.h>
 #include <itkParticleSwarmOptimizer.h>
 
+#include "sziBatchParticleSwarmOptimizer.h"
+
 namespace szi
 {
 
@@ -32,8 +34,17 @@ namespace szi
         {
         	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): =====start=====" << End;
 
+            itk::FancyString tagname = inputdom->GetName();
+
             OutputType* output = this->GetOutput();
-            if ( output == NULL )
+            if ( output == NULL && tagname == "BatchParticleSwarmOptimizer" )
+            {
+            	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Creating a new output batch PSO object ..." << End;
+                BatchParticleSwarmOptimizer::Pointer object = BatchParticleSwarmOptimizer::New();
+                output = (BatchParticleSwarmOptimizer*)object;
+                this->SetOutput( output );
+            }
+            else if ( output == NULL )
             {
             	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Creating a new output PSO object ..." << End;
                 OutputType::Pointer object = OutputType::New();
@@ -45,8 +56,7 @@ namespace szi
             	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Filling an existing output PSO object ..." << End;
             }
 
-            itk::FancyString objname = "ParticleSwarmOptimizer"; //output->GetNameOfClass();
-            if ( objname != inputdom->GetName() )
+            if ( tagname != "ParticleSwarmOptimizer" && tagname != "BatchParticleSwarmOptimizer" )
             {
             	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GenerateData(): Input DOM object is invalid!" << End;
             }
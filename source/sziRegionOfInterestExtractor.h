@@ -2,9 +2,10 @@
 #define _sziRegionOfInterestExtractor_h_
 
 #include <itkObject.h>
-#include <itkResampleImageFilter.h>
-#include <itkIdentityTransform.h>
-#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkImage.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+
+#include <algorithm>
 
 namespace szi
 {
@@ -48,6 +49,10 @@ namespace szi
             _defvalue = value;
         }
 
+        /**
+        Copy the region of interest into a new image whose index starts at zero, row by row; the pixels of the
+        region outside the input get the default value. If the region is the whole input, the input is returned.
+        */
         void update()
         {
             _output = 0;
@@ -55,34 +60,52 @@ namespace szi
             //
             _input->Update();
             //
-            typedef itk::ResampleImageFilter<ImageType,ImageType,double> ResamplerType;
-            typename ResamplerType::Pointer resampler = ResamplerType::New();
-            //
-            typedef itk::IdentityTransform<double,3> IdentityTransformType;
-            typename IdentityTransformType::Pointer I = IdentityTransformType::New();
-            resampler->SetTransform( I );
-            //
-            resampler->SetInput( _input );
-            resampler->SetSize( _roi.GetSize() );
-            //
-            typename ImageType::PointType origin = _input->GetOrigin();
-            for ( int i=0; i<ImageType::ImageDimension; i++ )
+            const RegionType& buffered = _input->GetBufferedRegion();
+            if ( _roi == buffered && buffered == _input->GetLargestPossibleRegion() )
             {
-                origin[i] = _input->GetSpacing()[i] * ( _roi.GetIndex(i) - _input->GetLargestPossibleRegion().GetIndex(i) ) + origin[i];
+                bool zero = true;
+                for ( int i=0; i<ImageType::ImageDimension; i++ ) zero = zero && ( _roi.GetIndex(i) == 0 );
+                if ( zero )
+                {
+                    _output = _input;
+                    return;
+                }
             }
-            resampler->SetOutputOrigin( origin );
             //
-            resampler->SetOutputSpacing( _input->GetSpacing() );
-            resampler->SetOutputDirection( _input->GetDirection() );
-            resampler->SetDefaultPixelValue( _defvalue );
+            typename ImageType::PointType origin;
+            _input->TransformIndexToPhysicalPoint( _roi.GetIndex(), origin );
             //
-            typedef itk::NearestNeighborInterpolateImageFunction<ImageType,double> InterpolatorType;
-            typename InterpolatorType::Pointer nninterp = InterpolatorType::New();
-            resampler->SetInterpolator( nninterp );
+            _output = OutputType::New();
+            _output->SetRegions( _roi.GetSize() );
+            _output->SetOrigin( origin );
+            _output->SetSpacing( _input->GetSpacing() );
+            _output->SetDirection( _input->GetDirection() );
+            _output->Allocate();
             //
-            resampler->Update();
+            RegionType inside = _roi;
+            if ( !( inside == buffered ) && !inside.Crop( buffered ) )
+            {
+                _output->FillBuffer( _defvalue );
+                return;
+            }
+            if ( !( inside == _roi ) )
+            {
+                _output->FillBuffer( _defvalue );
+            }
             //
-            _output = resampler->GetOutput();
+            // copy the rows of the region inside the input
+            typedef typename ImageType::IndexType IndexType;
+            const long width = inside.GetSize( 0 );
+            typedef itk::ImageLinearConstIteratorWithIndex<ImageType> IteratorType;
+            IteratorType it( _input, inside );
+            it.SetDirection( 0 );
+            for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+            {
+                IndexType idx = it.GetIndex();
+                const PixelType* src = &_input->GetPixel( idx );
+                for ( int i=0; i<ImageType::ImageDimension; i++ ) idx[i] -= _roi.GetIndex(i);
+                std::copy( src, src + width, &_output->GetPixel( idx ) );
+            }
         }
 
         OutputType* getOutput()
@@ -35,7 +35,7 @@ namespace szi
             std::string sCT;
             // segmentation image file name
             std::string sSegmentation;
-            // region-of-interest used for registration
+            // file caching the region-of-interest used for registration, by default the segmentation file name with ".roi"
             std::string sROI;
         };
 
@@ -110,8 +110,6 @@ namespace szi
 #include <itkImageRegistrationMethod.h>
 #include <itkImage.h>
 #include <itkImageFileReader.h>
-#include <itkKappaStatisticImageToImageMetric.h>
-#include <itkNearestNeighborInterpolateImageFunction.h>
 
 #include <itkCenteredTransformInitializer.h>
 #include <itkMatrixOffsetTransformBase.h>
@@ -120,6 +118,24 @@ namespace szi
 #include "sziTunable.h"
 #include "sziBoundingBoxFinder.h"
 #include "sziRegionOfInterestExtractor.h"
+#include "sziImageCache.h"
+#include "sziImagePack.h"
+#include "sziOptimizerValueTracker.h"
+#include "sziOverlapScorer.h"
+
+#include <itkTimeProbe.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace szi
 {
@@ -157,12 +173,37 @@ namespace szi
         typedef itk::ImageRegistrationMethod<CTImageType,CTImageType> RegistraterType;
         typedef RegistraterType::OptimizerType OptimizerType;
 
-        typedef itk::KappaStatisticImageToImageMetric<SegImageType,SegImageType> ScorerType;
+        typedef OverlapScorer<SegImageType> ScorerType;
 
         virtual void setData( DataType* data ) { Superclass::setData( data ); }
         DataType* getData() { return static_cast<DataType*>( Superclass::getData() ); }
         const DataType* getData() const { return static_cast<const DataType*>( Superclass::getData() ); }
 
+        /** Default maximum size (in MB) of the cache of cropped images. */
+        static const unsigned int DefaultImageCacheSize = 1024;
+
+        /** Set/get the maximum size (in MB) of the cache of cropped images, zero to disable caching. */
+        virtual void setImageCacheSize( unsigned int mb ) { this->m_ImageCache->setMaximumSize( (ImageCache::SizeType)mb << 20 ); }
+        unsigned int getImageCacheSize() const { return (unsigned int)( this->m_ImageCache->getMaximumSize() >> 20 ); }
+
+        /** Set/get whether the Hausdorff distance of the segmentations is reported with the final score (off by default). */
+        virtual void setComputeHausdorffDistance( bool on ) { this->m_ComputeHausdorffDistance = on; }
+        bool getComputeHausdorffDistance() const { return this->m_ComputeHausdorffDistance; }
+
+        /**
+        Set/get whether the score of the initial transform is logged before each registration (off by default).
+        It is computed once per training example and initial transform, and remembered afterwards.
+        */
+        virtual void setDiagnosticScoring( bool on ) { this->m_DiagnosticScoring = on; }
+        bool getDiagnosticScoring() const { return this->m_DiagnosticScoring; }
+
+        /**
+        Set/get the pack file holding the cropped images of the training examples (see packData()),
+        to be used instead of reading the image files; images missing from the pack are still read from their files.
+        */
+        virtual void setImagePackFileName( const std::string& fn ) { this->m_ImagePackFileName = fn; }
+        const std::string& getImagePackFileName() const { return this->m_ImagePackFileName; }
+
         virtual void setRegistrater( RegistraterType* r ) { this->m_Registrater = r; }
         RegistraterType* getRegistrater() { return this->m_Registrater; }
         const RegistraterType* getRegistrater() const { return this->m_Registrater; }
@@ -198,16 +239,18 @@ namespace szi
             }
 
             // initialize performance score calculator
-            ScorerType::Pointer scorer = ScorerType::New();
-            scorer->ComplementOn();
-            scorer->ComputeGradientOff();
+            this->m_Scorer = ScorerType::New();
+
+            // map the pack of preprocessed images once; the images found in a pack keep it mapped as long as they are used
+            if ( this->m_ImagePackFileName.empty() )
             {
-                typedef itk::NearestNeighborInterpolateImageFunction<SegImageType,double> NNInterpolatorType;
-                NNInterpolatorType::Pointer nn = NNInterpolatorType::New();
-                scorer->SetInterpolator( nn );
+                this->m_ImagePack = 0;
+            }
+            else if ( !this->m_ImagePack || this->m_ImagePack->getFileName() != this->m_ImagePackFileName )
+            {
+                this->m_ImagePack = ImagePack::New();
+                this->m_ImagePack->open( this->m_ImagePackFileName );
             }
-            //
-            this->m_Scorer = scorer;
 
             Superclass::initialize();
 
@@ -258,26 +301,60 @@ namespace szi
             Tunable* tunable = dynamic_cast<Tunable*>( registrater );
             const ParametersType& tparams = this->getTunableParameters();
             tunable->setTunableParameters( tparams );
-            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): tunable parameters " << tparams << End;
+            tunable->setCancellationToken( this->getCancellationToken() );
+            tunable->setFidelity( this->getFidelity() );
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): tunable parameters " << tparams << ", fidelity " << this->getFidelity() << End;
 
             // set/initialize the score calculator
 			ScorerType* scorer = this->m_Scorer;
-			scorer->SetFixedImage( this->m_FixedSegImage );
-			scorer->SetFixedImageRegion( this->m_FixedSegImage->GetBufferedRegion() );
-			scorer->SetMovingImage( this->m_MovingSegImage );
-			scorer->SetForegroundValue( data->seglabel );
-
-            // compute the initial performance score
-            const ParametersType& iparams = registrater->GetInitialTransformParameters();
+			scorer->setFixedImage( this->m_FixedSegImage );
+			scorer->setFixedImageRegion( this->m_FixedSegImage->GetBufferedRegion() );
+			scorer->setMovingImage( this->m_MovingSegImage );
+			scorer->setForegroundValue( data->seglabel );
+			scorer->setTransform( registrater->GetTransform() );
+
+            // compute the initial performance score, for diagnostics only
+            if ( this->m_DiagnosticScoring )
             {
-				scorer->SetTransform( registrater->GetTransform() );
-				scorer->Initialize();
-				MeasureType score = scorer->GetValue( iparams );
+				const ParametersType& iparams = registrater->GetInitialTransformParameters();
+
+				std::ostringstream key;
+				key.precision( 17 );
+				key << data->datadir << data->fdata.sFolder << data->fdata.sSegmentation << "|" << data->datadir << data->mdata.sFolder << data->mdata.sSegmentation << "|" << (int)data->seglabel;
+				for ( unsigned int i = 0; i < iparams.GetSize(); i++ )
+				{
+					key << "|" << iparams[i];
+				}
+
+				std::map<std::string,MeasureType>::const_iterator i = this->m_InitialScores.find( key.str() );
+				MeasureType score = 0;
+				if ( i != this->m_InitialScores.end() )
+				{
+					score = i->second;
+				}
+				else
+				{
+					scorer->setComputeHausdorffDistance( false );
+					scorer->compute( iparams );
+					score = scorer->getValue();
+					this->m_InitialScores[ key.str() ] = score;
+				}
 				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): initial score = " << score << End;
             }
 
             // perform score computation, i.e., the registration
+            itk::TimeProbe probe;
+            probe.Start();
             tunable->updatePerformanceScore();
+            probe.Stop();
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): registration took " << probe.GetTotal() << " s for " << this->m_IterCount << " iterations" << End;
+
+            // the registration has been stopped early, so its result is meaningless
+            if ( this->isCancelled() )
+            {
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): registration cancelled" << End;
+                throw "Performance score computation was cancelled!";
+            }
 
             // We will not use the performance score computed by the registration;
             // instead, we use the resulting transform to compute the overlap percentage between
@@ -286,10 +363,14 @@ namespace szi
             // compute the final performance score
             const ParametersType& fparams = this->m_FinalParams;
             {
-				scorer->SetTransform( registrater->GetTransform() );
-				scorer->Initialize();
-				MeasureType score = scorer->GetValue( fparams );
-				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): final score = " << score << End;
+				scorer->setComputeHausdorffDistance( this->m_ComputeHausdorffDistance );
+				scorer->compute( fparams );
+				MeasureType score = scorer->getValue();
+				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): final score = " << score << ", Dice = " << scorer->getDice() << ", Jaccard = " << scorer->getJaccard() << End;
+				if ( this->m_ComputeHausdorffDistance )
+				{
+					getSystemLogger() << StartInfo(this->GetNameOfClass()) << "updatePerformanceScore(): Hausdorff distance = " << scorer->getHausdorffDistance() << End;
+				}
 	            //
 	            this->setPerformanceScore( score );
             }
@@ -302,14 +383,21 @@ namespace szi
         	if ( ProgressEvent().CheckEvent(&eo) )
         	{
         		this->m_IterCount = 0;
+        		this->m_ValueTracker.reset();
         		return;
         	}
 
         	RegistraterType* registrater = this->getRegistrater();
         	OptimizerType* optimizer = registrater->GetOptimizer();
 
-        	const ParametersType& params = optimizer->GetCurrentPosition();
-        	double value = optimizer->GetValue( params );
+        	// use the metric value the optimizer has computed already, rather than evaluating the metric again
+        	ParametersType params;
+        	double value = 0;
+        	if ( !this->m_ValueTracker.update( optimizer, params, value ) )
+        	{
+        		params = optimizer->GetCurrentPosition();
+        		value = optimizer->GetValue( params );
+        	}
 
         	if ( this->m_IterCount == 0 || this->m_FinalValue > value )
         	{
@@ -322,111 +410,253 @@ namespace szi
         	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "Execute(): " << this->m_IterCount << " " << this->m_FinalValue << " " << value << End;
         }
 
+        /**
+        Read and crop the images of the current training example, and add them to a pack being written,
+        keyed as they are looked up by later evaluations.
+        */
+        void packData( ImagePack* pack )
+        {
+            DataType* data = this->getData();
+
+            const DataType::Actor* actors[] = { &data->fdata, &data->mdata };
+            for ( unsigned int i = 0; i < 2; i++ )
+            {
+                SegImageType::Pointer segImage;
+                CTImageType::Pointer ctImage;
+                this->loadActor( *actors[i], ( i == 0 ? "fixed" : "moving" ), segImage, ctImage );
+
+                std::string segkey, ctkey;
+                this->makeKeys( *actors[i], segkey, ctkey );
+                pack->addImage( segkey, segImage.GetPointer() );
+                pack->addImage( ctkey, ctImage.GetPointer() );
+            }
+        }
+
     protected:
         /**
-        Read CT and segmentation images from disk.
+        Read CT and segmentation images from disk, or take them from the image cache
+        if they have been read and cropped before, or from the image pack.
         */
         void loadData()
         {
             DataType* data = this->getData();
 
-            // read and crop the fixed image segmentation
-            RegionType fROI;
+            this->loadActor( data->fdata, "fixed", this->m_FixedSegImage, this->m_FixedImage );
+            this->loadActor( data->mdata, "moving", this->m_MovingSegImage, this->m_MovingImage );
+
+            this->m_ImageCache->report( this->GetNameOfClass() );
+        }
+
+        /**
+        Read and crop the segmentation and CT images of the fixed or moving data.
+        */
+        void loadActor( const DataType::Actor& actor, const char* name, SegImageType::Pointer& segImage, CTImageType::Pointer& ctImage )
+        {
+            DataType* data = this->getData();
+
+            std::string fnseg = data->datadir + actor.sFolder + actor.sSegmentation;
+            std::string fnct = data->datadir + actor.sFolder + actor.sCT;
+
+            std::string segkey, ctkey;
+            this->makeKeys( actor, segkey, ctkey );
+
+            segImage = dynamic_cast<SegImageType*>( this->m_ImageCache->find( segkey ) );
+            ctImage = dynamic_cast<CTImageType*>( this->m_ImageCache->find( ctkey ) );
+            if ( segImage && ctImage )
             {
-                std::string fn = data->datadir + data->fdata.sFolder + data->fdata.sSegmentation;
-                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read fixed image segmentation from " << fn << End;
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): " << name << " images found in the cache" << End;
+                return;
+            }
+
+            // the images of the pack are views of its mapping, so they are not cached
+            if ( this->m_ImagePack )
+            {
+                segImage = this->m_ImagePack->findImage<SegImageType>( segkey );
+                ctImage = this->m_ImagePack->findImage<CTImageType>( ctkey );
+                if ( segImage && ctImage )
+                {
+                    getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): " << name << " images found in the pack" << End;
+                    return;
+                }
+            }
+
+            // the region-of-interest is the bounding box of the label, cached in a file such that
+            // only the region is read from the image files by later evaluations
+            std::string fnroi = actor.sROI.empty() ? fnseg + ".roi" : data->datadir + actor.sFolder + actor.sROI;
+            RegionType roi;
+            bool known = this->readRegionOfInterest( fnroi, data->seglabel, roi );
+
+            // read and crop the image segmentation
+            {
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read " << name << " image segmentation from " << fnseg << End;
 
                 typedef itk::ImageFileReader<SegImageType> ImageReaderType;
                 ImageReaderType::Pointer imgReader = ImageReaderType::New();
-                imgReader->SetFileName( fn.c_str() );
+                imgReader->SetFileName( fnseg.c_str() );
+                if ( known && !this->requestRegion( (ImageReaderType*)imgReader, roi ) )
+                {
+                    getSystemLogger() << StartWarning(this->GetNameOfClass()) << "loadData(): region-of-interest " << roi << " read from " << fnroi << " is outside of " << fnseg << ", finding it again" << End;
+                    known = false;
+                }
                 imgReader->Update();
-                SegImageType* fseg = imgReader->GetOutput();
-
-                typedef BoundingBoxFinder<SegImageType> BBFinderType;
-                BBFinderType::Pointer finder = BBFinderType::New();
-                finder->setInput( fseg );
-                finder->setLabelValue( data->seglabel );
-                finder->update();
-                fROI = finder->getOutput();
+                SegImageType* seg = imgReader->GetOutput();
+
+                if ( !known )
+                {
+                    typedef BoundingBoxFinder<SegImageType> BBFinderType;
+                    BBFinderType::Pointer finder = BBFinderType::New();
+                    finder->setInput( seg );
+                    finder->setLabelValue( data->seglabel );
+                    finder->update();
+                    roi = finder->getOutput();
+
+                    if ( roi.GetNumberOfPixels() == 0 )
+                    {
+                        getSystemLogger() << StartFatal(this->GetNameOfClass()) << "loadData(): label " << data->seglabel << " not found in " << fnseg << End;
+                    }
+                    this->writeRegionOfInterest( fnroi, data->seglabel, roi );
+                }
 
                 typedef RegionOfInterestExtractor<SegImageType> ExtractorType;
                 ExtractorType::Pointer extractor = ExtractorType::New();
-                extractor->setInput( fseg );
-                extractor->setRegionOfInterest( fROI );
+                extractor->setInput( seg );
+                extractor->setRegionOfInterest( roi );
                 extractor->update();
-                this->m_FixedSegImage = extractor->getOutput();
+                segImage = extractor->getOutput();
             }
 
-            // read and crop the fixed image
+            // read and crop the image, streaming only the region-of-interest from the file if possible
             {
-                std::string fn = data->datadir + data->fdata.sFolder + data->fdata.sCT;
-                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read fixed image from " << fn << End;
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read " << name << " image from " << fnct << End;
 
                 typedef itk::ImageFileReader<CTImageType> ImageReaderType;
                 ImageReaderType::Pointer imgReader = ImageReaderType::New();
-                imgReader->SetFileName( fn.c_str() );
+                imgReader->SetFileName( fnct.c_str() );
+                if ( !this->requestRegion( (ImageReaderType*)imgReader, roi ) )
+                {
+                    getSystemLogger() << StartFatal(this->GetNameOfClass()) << "loadData(): region-of-interest " << roi << " is outside of " << fnct << End;
+                }
                 imgReader->Update();
-                CTImageType* fImage = imgReader->GetOutput();
+                CTImageType* image = imgReader->GetOutput();
 
                 typedef RegionOfInterestExtractor<CTImageType> ExtractorType;
                 ExtractorType::Pointer extractor = ExtractorType::New();
-                extractor->setInput( fImage );
-                extractor->setRegionOfInterest( fROI );
+                extractor->setInput( image );
+                extractor->setRegionOfInterest( roi );
                 extractor->update();
-                this->m_FixedImage = extractor->getOutput();
+                ctImage = extractor->getOutput();
             }
 
-            // read and crop the moving image segmentation
-            RegionType mROI;
-            {
-                std::string fn = data->datadir + data->mdata.sFolder + data->mdata.sSegmentation;
-                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read moving image segmentation from " << fn << End;
+            this->m_ImageCache->insert( segkey, segImage, segImage->GetBufferedRegion().GetNumberOfPixels() * sizeof(SegPixelType) );
+            this->m_ImageCache->insert( ctkey, ctImage, ctImage->GetBufferedRegion().GetNumberOfPixels() * sizeof(CTPixelType) );
+        }
 
-                typedef itk::ImageFileReader<SegImageType> ImageReaderType;
-                ImageReaderType::Pointer imgReader = ImageReaderType::New();
-                imgReader->SetFileName( fn.c_str() );
-                imgReader->Update();
-                SegImageType* mseg = imgReader->GetOutput();
+        /** Make the keys of the cropped segmentation and CT images of the fixed or moving data, the cropping region depending on the segmentation and the label. */
+        void makeKeys( const DataType::Actor& actor, std::string& segkey, std::string& ctkey ) const
+        {
+            const DataType* data = this->getData();
 
-                typedef BoundingBoxFinder<SegImageType> BBFinderType;
-                BBFinderType::Pointer finder = BBFinderType::New();
-                finder->setInput( mseg );
-                finder->setLabelValue( data->seglabel );
-                finder->update();
-                mROI = finder->getOutput();
+            itk::FancyString seg;
+            seg << "seg|" << data->datadir + actor.sFolder + actor.sSegmentation << "|" << data->seglabel;
+            itk::FancyString ct;
+            ct << "ct|" << data->datadir + actor.sFolder + actor.sCT << "|" << seg;
 
-                typedef RegionOfInterestExtractor<SegImageType> ExtractorType;
-                ExtractorType::Pointer extractor = ExtractorType::New();
-                extractor->setInput( mseg );
-                extractor->setRegionOfInterest( mROI );
-                extractor->update();
-                this->m_MovingSegImage = extractor->getOutput();
+            segkey = seg;
+            ctkey = ct;
+        }
+
+        /**
+        Request only the region-of-interest from a reader, such that an image IO supporting streaming
+        (e.g. MetaImageIO for uncompressed files) reads only this region from the file.
+        Return false, requesting nothing, if the region is empty or not inside the image.
+        */
+        template < class TReader >
+        bool requestRegion( TReader* reader, const RegionType& roi )
+        {
+            reader->UpdateOutputInformation();
+            if ( roi.GetNumberOfPixels() == 0 || !reader->GetOutput()->GetLargestPossibleRegion().IsInside( roi ) )
+            {
+                return false;
             }
+            reader->GetOutput()->SetRequestedRegion( roi );
+            return true;
+        }
 
-            // read and crop the moving image
+        /**
+        Read the region-of-interest of a label from its file; return false if the file is missing, for another label,
+        or not a complete region-of-interest file.
+        */
+        bool readRegionOfInterest( const std::string& fn, short label, RegionType& roi )
+        {
+            std::ifstream ifs( fn.c_str() );
+            if ( !ifs ) return false;
+
+            short l = 0;
+            RegionType::IndexType index;
+            RegionType::SizeType size;
+            std::string end;
+            ifs >> l;
+            for ( unsigned int i = 0; i < SpaceDimension; i++ ) ifs >> index[i];
+            for ( unsigned int i = 0; i < SpaceDimension; i++ ) ifs >> size[i];
+            ifs >> end;
+            if ( !ifs || end != "end" || !( ifs >> std::ws ).eof() )
             {
-                std::string fn = data->datadir + data->mdata.sFolder + data->mdata.sCT;
-                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "loadData(): read moving image from " << fn << End;
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "readRegionOfInterest(): " << fn << " is not a region-of-interest file, ignored" << End;
+                return false;
+            }
+            if ( l != label ) return false;
 
-                typedef itk::ImageFileReader<CTImageType> ImageReaderType;
-                ImageReaderType::Pointer imgReader = ImageReaderType::New();
-                imgReader->SetFileName( fn.c_str() );
-                imgReader->Update();
-                CTImageType* mImage = imgReader->GetOutput();
+            roi.SetIndex( index );
+            roi.SetSize( size );
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "readRegionOfInterest(): " << roi.GetIndex() << " " << roi.GetSize() << " read from " << fn << End;
+            return true;
+        }
 
-                typedef RegionOfInterestExtractor<CTImageType> ExtractorType;
-                ExtractorType::Pointer extractor = ExtractorType::New();
-                extractor->setInput( mImage );
-                extractor->setRegionOfInterest( mROI );
-                extractor->update();
-                this->m_MovingImage = extractor->getOutput();
+        /**
+        Write the region-of-interest of a label to its file, for later evaluations; a failure only costs the next evaluation a full read.
+        As the slaves may write the same file at the same time, each writes its own temporary file first and then renames it, such that
+        the file is always complete; the line ends with "end" to tell it from a file cut by an interruption.
+        */
+        void writeRegionOfInterest( const std::string& fn, short label, const RegionType& roi )
+        {
+            // a temporary file name unique to this process, also among the hosts sharing the file
+            std::ostringstream oss;
+            char host[256] = "";
+#ifdef _WIN32
+            oss << fn << ".tmp." << _getpid();
+#else
+            gethostname( host, sizeof(host) - 1 );
+            oss << fn << ".tmp." << host << "." << getpid();
+#endif
+            std::string tmpname = oss.str();
+
+            std::ofstream ofs( tmpname.c_str() );
+            ofs << label;
+            for ( unsigned int i = 0; i < SpaceDimension; i++ ) ofs << " " << roi.GetIndex()[i];
+            for ( unsigned int i = 0; i < SpaceDimension; i++ ) ofs << " " << roi.GetSize()[i];
+            ofs << " end" << std::endl;
+            ofs.close();
+            if ( !ofs )
+            {
+                getSystemLogger() << StartWarning(this->GetNameOfClass()) << "writeRegionOfInterest(): cannot write to " << tmpname << End;
+                std::remove( tmpname.c_str() );
+                return;
+            }
+
+            // on Windows, rename() does not replace an existing file, which another slave has just written then
+            if ( std::rename( tmpname.c_str(), fn.c_str() ) != 0 )
+            {
+                std::remove( tmpname.c_str() );
             }
         }
 
-        RegistrationSystem() : m_IterCount(0), m_FinalValue(0)
+        RegistrationSystem() : m_ComputeHausdorffDistance(false), m_DiagnosticScoring(false), m_IterCount(0), m_FinalValue(0)
         {
             DataType::Pointer data = DataType::New();
             this->setData( (DataType*)data );
+
+            this->m_ImageCache = ImageCache::New();
+            this->m_ImageCache->setMaximumSize( (ImageCache::SizeType)DefaultImageCacheSize << 20 );
         }
 
     private:
@@ -435,6 +665,10 @@ namespace szi
 
         RegistraterType::Pointer m_Registrater;
         ScorerType::Pointer m_Scorer;
+        bool m_ComputeHausdorffDistance;
+
+        bool m_DiagnosticScoring;
+        std::map<std::string,MeasureType> m_InitialScores;
 
         CTImageType::Pointer m_FixedImage;
         SegImageType::Pointer m_FixedSegImage;
@@ -442,7 +676,13 @@ namespace szi
         CTImageType::Pointer m_MovingImage;
         SegImageType::Pointer m_MovingSegImage;
 
+        ImageCache::Pointer m_ImageCache;
+
+        std::string m_ImagePackFileName;
+        ImagePack::Pointer m_ImagePack;
+
         int m_IterCount;
+        OptimizerValueTracker m_ValueTracker;
         ParametersType m_FinalParams;
         double m_FinalValue;
     };
@@ -242,6 +242,37 @@ namespace szi
 				getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): Tunable parameters were not provided!" << End;
 			}
 
+			// read the maximum size (in MB) of the cache of cropped images
+			s = inputdom->GetAttribute( "ImageCacheSize" );
+			if ( s != "" )
+			{
+				unsigned int mb = 0;
+				s >> mb;
+				output->setImageCacheSize( mb );
+				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ImageCacheSize = " << mb << " MB" << End;
+			}
+
+			s = inputdom->GetAttribute( "ImagePack" );
+			if ( s != "" )
+			{
+				output->setImagePackFileName( s );
+				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ImagePack = " << s << End;
+			}
+
+			s = inputdom->GetAttribute( "ComputeHausdorffDistance" );
+			if ( s == "1" || s == "on" )
+			{
+				output->setComputeHausdorffDistance( true );
+				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ComputeHausdorffDistance = on" << End;
+			}
+
+			s = inputdom->GetAttribute( "DiagnosticScoring" );
+			if ( s == "1" || s == "on" )
+			{
+				output->setDiagnosticScoring( true );
+				getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): DiagnosticScoring = on" << End;
+			}
+
 			getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): -----e-n-d-----" << End;
         }
 
@@ -119,7 +119,13 @@ namespace szi
             size_t n = 0;
             this->streamOut( n );
             //
-            if ( n )
+            // a length beyond the data left (e.g. of a truncated stream) is not trusted
+            if ( n > (size_t)this->getSize() )
+            {
+                _head = _tail;
+                s = "";
+            }
+            else if ( n )
             {
                 char* buf = new char[n];
                 this->streamOut( buf, n );
@@ -130,6 +136,18 @@ namespace szi
         }
 
         void flush() { _head = _tail = 0; }
+
+        /**
+        Discard the content, and make the buffer hold the given number of bytes, to be written
+        directly into the memory returned (e.g. by MPI_Recv). The memory is reused if large enough.
+        */
+        void* reset( long size )
+        {
+            this->flush();
+            if ( size > _capacity ) this->changeCapacity( size );
+            _tail = size;
+            return _pointer;
+        }
     };
 
     /**
@@ -191,6 +209,12 @@ inline szi::StreamBuffer& operator>>( szi::StreamBuffer& sb, itk::Array<T>& data
     unsigned int n = 0;
     sb >> n;
     //
+    // a length beyond the data left (e.g. of a truncated stream) is not trusted
+    if ( n > (size_t)sb.getSize() / sizeof(T) )
+    {
+        sb.setOutPosition( sb.getInPosition() );
+        n = 0;
+    }
     data.SetSize( n );
     for ( unsigned int i = 0; i < n; i++ ) sb >> data[i];
     //
@@ -4,8 +4,10 @@
 #include <itkSingleValuedCostFunction.h>
 #include "sziMPIJob.h"
 #include "sziTunable.h"
+#include "sziBatchCostFunction.h"
 
 #include "sziSystemData.h"
+#include "sziSystemEvaluation.h"
 
 namespace szi
 {
@@ -17,7 +19,7 @@ namespace szi
     - a set of internal parameters; and
     - the performance score under the current setting of parameters.
     */
-    class System : public itk::SingleValuedCostFunction, public MPIJob, public Tunable
+    class System : public itk::SingleValuedCostFunction, public BatchCostFunction, public MPIJob, public Tunable
     {
     public:
         /** Standard class typedefs. */
@@ -34,6 +36,12 @@ namespace szi
         //
         typedef Superclass::ParametersType ParametersType;
         typedef Superclass::MeasureType MeasureType;
+        //
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+        //
+        typedef SystemEvaluation EvaluationType;
+        typedef EvaluationType::Pointer EvaluationPointer;
 
         virtual void setData( DataType* data ) { MPIJob::setData( data ); }
         DataType* getData() { return static_cast<DataType*>( MPIJob::getData() ); }
@@ -41,6 +49,72 @@ namespace szi
 
         virtual void updatePerformanceScore() = 0;
 
+        /**
+        Start the computation of the performance score for a training example under a setting of
+        tunable parameters, at the given fidelity (see Tunable::setFidelity()), and return a handle to collect
+        the score later on with waitEvaluation().
+        The default implementation computes the score right away using this system; subclasses that
+        are able to compute several scores at the same time (e.g. by forwarding them to remote workers)
+        should return as soon as the computation has been started, blocking only while all of their
+        resources are busy.
+        */
+        virtual EvaluationPointer submitEvaluation( DataType* data, const ParametersType& params, double fidelity = 1.0 )
+        {
+            EvaluationPointer evaluation = EvaluationType::New();
+            evaluation->setData( data );
+            evaluation->setParameters( params );
+            evaluation->setFidelity( fidelity );
+            evaluation->setState( EvaluationType::EVALUATION_SUBMITTED );
+
+            this->setData( data );
+            this->setTunableParameters( params );
+            this->setFidelity( fidelity );
+            this->updatePerformanceScore();
+            this->setFidelity( 1 );
+
+            evaluation->setScore( this->getPerformanceScore() );
+            evaluation->setState( EvaluationType::EVALUATION_DONE );
+
+            return evaluation;
+        }
+
+        /**
+        Block until a previously submitted evaluation is done, and return the resulting score.
+        */
+        virtual MeasureType waitEvaluation( EvaluationType* evaluation )
+        {
+            if ( !evaluation->isDone() )
+            {
+                getSystemLogger() << StartFatal(this->GetNameOfClass()) << "waitEvaluation(): evaluation was not submitted to this system" << End;
+            }
+            return evaluation->getScore();
+        }
+
+        /**
+        Give up a previously submitted evaluation whose score is no longer needed; it must not be waited for
+        afterwards. The default implementation has nothing to cancel, as the score is computed right away;
+        subclasses should free the resources held by the evaluation as soon as possible.
+        */
+        virtual void cancelEvaluation( EvaluationType* evaluation )
+        {
+            if ( !evaluation->isDone() )
+            {
+                evaluation->setState( EvaluationType::EVALUATION_CANCELLED );
+            }
+        }
+
+        /**
+        Return the estimated time (in seconds) of evaluating a training example, or zero if unknown.
+        Users can submit the longest evaluations first to balance the load of concurrent evaluations.
+        */
+        virtual double getEstimatedEvaluationTime( const DataType* data ) const { return 0; }
+
+        /**
+        Return the number of evaluations that can be in progress at the same time,
+        i.e. how many evaluations a user may submit before waiting for the first one.
+        */
+        virtual unsigned int getNumberOfConcurrentEvaluations() const { return 1; }
+
         /**
         Abstract method from MPIJob to run this system as an executable task.
         The default task is to compute the performance score of this system under current system parameters.
@@ -63,6 +137,33 @@ namespace szi
             return self->getPerformanceScore();
         }
 
+        using BatchCostFunction::GetValues;
+
+        /**
+        Compute the performance scores of the current data under a number of settings of
+        tunable parameters, submitting all of them before collecting the scores.
+        */
+        virtual void GetValues( const ParametersListType& params, MeasureListType& values ) const
+        {
+            Self* self = const_cast<Self*>( this );
+
+            DataType* data = self->getData();
+
+            unsigned int n = params.size();
+
+            std::vector<EvaluationPointer> evaluations( n );
+            for ( unsigned int i = 0; i < n; i++ )
+            {
+                evaluations[i] = self->submitEvaluation( data, params[i] );
+            }
+
+            values.resize( n );
+            for ( unsigned int i = 0; i < n; i++ )
+            {
+                values[i] = self->waitEvaluation( evaluations[i] );
+            }
+        }
+
         virtual void GetDerivative( const ParametersType& params, DerivativeType& deriv ) const
         {
         	getSystemLogger() << StartFatal(this->GetNameOfClass()) << "GetDerivative(): derivative calculation is not supported" << End;
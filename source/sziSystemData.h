@@ -33,6 +33,12 @@ namespace szi
         ParametersType m_Parameters;
         MeasureType m_Score;
 
+        // identifier of the training example, i.e. its index in the training data set
+        int m_ExampleId;
+
+        // fraction of the full computation to spend on the score, in (0,1], see Tunable::setFidelity()
+        double m_Fidelity;
+
         // write self to a StreamBuffer
         virtual void streamOut( StreamBuffer& sb ) const
         {
@@ -40,6 +46,8 @@ namespace szi
             //
             sb << (const itk::Array<double>&)this->m_Parameters;
             sb << this->m_Score;
+            sb << this->m_ExampleId;
+            sb << this->m_Fidelity;
         }
 
         // read and update self from a StreamBuffer
@@ -49,10 +57,28 @@ namespace szi
             //
             sb >> (itk::Array<double>&)this->m_Parameters;
             sb >> this->m_Score;
+            sb >> this->m_ExampleId;
+            sb >> this->m_Fidelity;
+        }
+
+        /**
+        Create a copy of this data object, which is of the same type as this one,
+        by streaming this object into the newly created one.
+        */
+        Pointer clone() const
+        {
+            itk::LightObject::Pointer object = this->CreateAnother();
+            Self* copy = dynamic_cast<Self*>( object.GetPointer() );
+
+            StreamBuffer sb;
+            sb << (const Streamable&)(*this);
+            sb >> (Streamable&)(*copy);
+
+            return Pointer( copy );
         }
 
     protected:
-        SystemData() : m_Score( 0 ) {}
+        SystemData() : m_Score( 0 ), m_ExampleId( -1 ), m_Fidelity( 1 ) {}
 
     private:
         SystemData( const Self & ); // purposely not implemented
@@ -0,0 +1,111 @@
+#ifndef _sziSystemEvaluation_h_
+#define _sziSystemEvaluation_h_
+
+#include <itkLightObject.h>
+#include <itkSimpleFastMutexLock.h>
+
+#include "sziSystemData.h"
+
+namespace szi
+{
+
+    /**
+    Class to represent one pending or finished evaluation of a system, i.e. the computation
+    of the performance score for a single training example under a single setting of the
+    tunable parameters. It is returned by System::submitEvaluation() and serves as a handle
+    to collect the result later on with System::waitEvaluation().
+    */
+    class SystemEvaluation : public itk::LightObject
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef SystemEvaluation Self;
+        typedef itk::LightObject Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Method for object creation without using the object factory. */
+        itkFactorylessNewMacro( Self );
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::SystemEvaluation, LightObject );
+
+        enum State { EVALUATION_UNKNOWN=0, EVALUATION_SUBMITTED, EVALUATION_DONE, EVALUATION_CANCELLED };
+
+        typedef SystemData DataType;
+        typedef DataType::ParametersType ParametersType;
+        typedef DataType::MeasureType MeasureType;
+
+        /** Set/get the training example to be evaluated. */
+        void setData( DataType* data ) { this->m_Data = data; }
+        DataType* getData() { return this->m_Data; }
+        const DataType* getData() const { return this->m_Data; }
+
+        /** Set/get the setting of the tunable parameters to be evaluated. */
+        void setParameters( const ParametersType& params ) { this->m_Parameters = params; }
+        const ParametersType& getParameters() const { return this->m_Parameters; }
+
+        /** Set/get the fidelity of the score to be computed, see Tunable::setFidelity(). */
+        void setFidelity( double fidelity ) { this->m_Fidelity = fidelity; }
+        double getFidelity() const { return this->m_Fidelity; }
+
+        /** Set/get the resulting performance score, only valid when the evaluation is done. */
+        void setScore( MeasureType score ) { this->m_Score = score; }
+        MeasureType getScore() const { return this->m_Score; }
+
+        /** Set/get the rank of the job (channel) that computes this evaluation, or -1 if none. */
+        void setChannel( int channel ) { this->m_Channel = channel; }
+        int getChannel() const { return this->m_Channel; }
+
+        /** Set/get the time (in seconds) when the computation was started. */
+        void setStartTime( double t ) { this->m_StartTime = t; }
+        double getStartTime() const { return this->m_StartTime; }
+
+        /** Set/get the number of times the computation has failed, and the channel it failed on last. */
+        void setNumberOfFailures( unsigned int n ) { this->m_NumberOfFailures = n; }
+        unsigned int getNumberOfFailures() const { return this->m_NumberOfFailures; }
+        void setFailedChannel( int channel ) { this->m_FailedChannel = channel; }
+        int getFailedChannel() const { return this->m_FailedChannel; }
+
+        /** Set/get the current state of this evaluation. */
+        void setState( State state )
+        {
+            this->m_StateLocker.Lock();
+            this->m_State = state;
+            this->m_StateLocker.Unlock();
+        }
+        State getState() const
+        {
+            State result = EVALUATION_UNKNOWN;
+            this->m_StateLocker.Lock();
+            result = this->m_State;
+            this->m_StateLocker.Unlock();
+            return result;
+        }
+
+        bool isDone() const { return ( this->getState() == EVALUATION_DONE ); }
+        bool isCancelled() const { return ( this->getState() == EVALUATION_CANCELLED ); }
+
+    protected:
+        SystemEvaluation() : m_Fidelity(1), m_Score(0), m_Channel(-1), m_StartTime(0), m_NumberOfFailures(0), m_FailedChannel(-1), m_State(EVALUATION_UNKNOWN) {}
+
+    private:
+        SystemEvaluation( const Self & ); // purposely not implemented
+        SystemEvaluation& operator=( const Self & ); // purposely not implemented
+
+        DataType::Pointer m_Data;
+        ParametersType m_Parameters;
+        double m_Fidelity;
+        MeasureType m_Score;
+        int m_Channel;
+        double m_StartTime;
+        unsigned int m_NumberOfFailures;
+        int m_FailedChannel;
+
+        State m_State;
+        itk::SimpleFastMutexLock m_StateLocker;
+    };
+
+} // namespace szi
+
+#endif // _sziSystemEvaluation_h_
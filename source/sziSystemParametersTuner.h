@@ -6,8 +6,15 @@
 #include "sziCommandInterface.h"
 
 #include "sziSystemTrainingMetric.h"
+#include "sziOptimizerValueTracker.h"
+#include "sziCheckpointable.h"
 #include <itkSingleValuedNonLinearOptimizer.h>
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
 namespace szi
 {
 
@@ -59,6 +66,22 @@ namespace szi
 
         virtual int getCurrentIteration() const { return this->m_IterationCount; }
 
+        /**
+        Set/get the file the progress of the tuning is saved to, as a checkpoint, after every given number of
+        iterations (1 by default, 0 to disable checkpointing). The checkpoint holds the best setting so far,
+        the state of the optimizer if it supports it (e.g. the particles of BatchParticleSwarmOptimizer),
+        and the scores computed so far. Without a file name, no checkpoint is written.
+        */
+        virtual void setCheckpointFileName( const std::string& fn ) { this->m_CheckpointFileName = fn; }
+        const std::string& getCheckpointFileName() const { return this->m_CheckpointFileName; }
+        //
+        virtual void setCheckpointInterval( unsigned int n ) { this->m_CheckpointInterval = n; }
+        unsigned int getCheckpointInterval() const { return this->m_CheckpointInterval; }
+
+        /** Set/get whether the tuning resumes from the checkpoint, if the file exists. */
+        virtual void setResume( bool resume ) { this->m_Resume = resume; }
+        bool getResume() const { return this->m_Resume; }
+
         /**
         Executable method to prepare for parameters tuning.
         */
@@ -107,11 +130,35 @@ namespace szi
             OptimizerType* optimizer = this->getOptimizer();
 
             this->m_IterationCount = 0;
+            this->m_ValueTracker.reset();
 
             optimizer->SetInitialPosition( this->m_InitialParameters );
 
+            if ( this->m_Resume && this->restoreCheckpoint() &&
+                 !dynamic_cast<Checkpointable*>( optimizer ) && this->m_FinalParameters.GetSize() > 0 )
+            {
+                // the optimizer cannot resume by itself, so restart it from the best setting so far
+                optimizer->SetInitialPosition( this->m_FinalParameters );
+            }
+
             optimizer->StartOptimization();
 
+            if ( this->m_CheckpointInterval > 0 )
+            {
+                this->saveCheckpoint();
+            }
+
+            MetricType* metric = this->getMetric();
+            EvaluationCache* cache = metric->getEvaluationCache();
+            if ( cache )
+            {
+                cache->report( this->GetNameOfClass() );
+            }
+            if ( metric->getRacing() )
+            {
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "execute(): racing skipped " << metric->getNumberOfSkippedEvaluations() << " of " << ( metric->getNumberOfEvaluations() + metric->getNumberOfSkippedEvaluations() ) << " evaluations" << End;
+            }
+
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "execute(): -----e-n-d-----" << End;
         }
 
@@ -122,25 +169,190 @@ namespace szi
         {
             const OptimizerType* optimizer = this->getOptimizer();
 
-            const ParametersType& curpos = optimizer->GetCurrentPosition();
-            double curval = optimizer->GetValue( curpos );
+            // use the value the optimizer has computed already, rather than evaluating all training examples again
+            ParametersType curpos;
+            double curval = 0;
+            if ( !this->m_ValueTracker.update( optimizer, curpos, curval ) )
+            {
+                curpos = optimizer->GetCurrentPosition();
+                curval = optimizer->GetValue( curpos );
+            }
 
             if ( this->m_IterationCount == 0 || this->m_FinalValue > curval )
             {
                 this->m_FinalParameters = curpos;
                 this->m_FinalValue = curval;
+
+                // settings that cannot beat the best one so far need not be evaluated completely
+                this->getMetric()->setIncumbentValue( curval );
             }
 
             this->m_IterationCount++;
 
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "Execute(): " << this->m_IterationCount << " " << this->m_FinalValue << " " << curval << End;
 
+            if ( this->m_CheckpointInterval > 0 && this->m_IterationCount % this->m_CheckpointInterval == 0 )
+            {
+                this->saveCheckpoint();
+            }
+
             // forward the event to observers of this object
             this->InvokeEvent( eo );
         }
 
     protected:
-        SystemParametersTuner() : m_FinalValue(0), m_IterationCount(0) {}
+        SystemParametersTuner() : m_FinalValue(0), m_IterationCount(0), m_CheckpointInterval(1), m_Resume(false) {}
+
+        /**
+        Write the checkpoint to a temporary file first, and then rename it, such that the previous
+        checkpoint remains intact if the job fails while writing.
+        */
+        void saveCheckpoint()
+        {
+            if ( this->m_CheckpointFileName.empty() ) return;
+
+            StreamBuffer sb;
+            sb << std::string( getCheckpointSignature() );
+
+            sb << this->m_IterationCount;
+            sb << this->m_FinalValue;
+            sb << (const itk::Array<double>&)this->m_FinalParameters;
+
+            // each section is preceded by its size, such that it can be skipped if it cannot be restored
+            const OptimizerType* optimizer = this->getOptimizer();
+            StreamBuffer section;
+            if ( const Checkpointable* c = dynamic_cast<const Checkpointable*>( optimizer ) )
+            {
+                c->saveState( section );
+            }
+            sb << std::string( optimizer->GetNameOfClass() );
+            sb << section.getSize();
+            sb.streamIn( section );
+
+            section.flush();
+            const EvaluationCache* cache = this->getMetric()->getEvaluationCache();
+            if ( cache )
+            {
+                cache->saveState( section );
+            }
+            sb << section.getSize();
+            sb.streamIn( section );
+
+            std::string tmpname = this->m_CheckpointFileName + ".tmp";
+            std::ofstream ofs( tmpname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            ofs.write( (const char*)sb.getPointer(), sb.getSize() );
+            ofs.close();
+            if ( !ofs )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "saveCheckpoint(): cannot write \"" << tmpname << "\"" << End;
+                return;
+            }
+
+#ifdef _WIN32
+            // rename() does not replace an existing file on Windows
+            std::remove( this->m_CheckpointFileName.c_str() );
+#endif
+            if ( std::rename( tmpname.c_str(), this->m_CheckpointFileName.c_str() ) != 0 )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "saveCheckpoint(): cannot rename \"" << tmpname << "\" to \"" << this->m_CheckpointFileName << "\"" << End;
+                return;
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "saveCheckpoint(): iteration " << this->m_IterationCount << " saved to \"" << this->m_CheckpointFileName << "\"" << End;
+        }
+
+        /** Read the checkpoint, if any, and restore the tuner, the optimizer and the scores. Return true if restored. */
+        bool restoreCheckpoint()
+        {
+            std::ifstream ifs( this->m_CheckpointFileName.c_str(), std::ios::in | std::ios::binary );
+            if ( this->m_CheckpointFileName.empty() || !ifs )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreCheckpoint(): no checkpoint to resume from, starting over" << End;
+                return false;
+            }
+
+            ifs.seekg( 0, std::ios::end );
+            long size = (long)ifs.tellg();
+            if ( size < 0 ) size = 0;
+            ifs.seekg( 0, std::ios::beg );
+
+            StreamBuffer sb;
+            ifs.read( (char*)sb.reset( size ), size );
+
+            // check the signature bytes before trusting any length field of the file
+            const std::string signature( getCheckpointSignature() );
+            size_t n = 0;
+            sb >> n;
+            if ( !ifs || n != signature.size() || sb.getSize() < (long)n || std::memcmp( sb.getPointer(), signature.data(), n ) != 0 )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreCheckpoint(): \"" << this->m_CheckpointFileName << "\" is not a valid checkpoint, starting over" << End;
+                return false;
+            }
+            sb.setOutPosition( sb.getOutPosition() + (long)n );
+
+            // read the whole checkpoint before restoring anything, such that a truncated one is ignored
+            int iteration = 0;
+            double value = 0;
+            ParametersType params;
+            sb >> iteration;
+            sb >> value;
+            sb >> (itk::Array<double>&)params;
+
+            std::string name;
+            long optimizerLength = -1;
+            sb >> name;
+            sb >> optimizerLength;
+            long optimizerPosition = sb.getOutPosition();
+            bool valid = ( optimizerLength >= 0 && optimizerLength <= sb.getSize() );
+
+            long cacheLength = -1;
+            long cachePosition = 0;
+            if ( valid )
+            {
+                sb.setOutPosition( optimizerPosition + optimizerLength );
+                sb >> cacheLength;
+                cachePosition = sb.getOutPosition();
+                valid = ( cacheLength >= 0 && cacheLength <= sb.getSize() );
+            }
+            if ( !valid )
+            {
+            	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "restoreCheckpoint(): \"" << this->m_CheckpointFileName << "\" is truncated or corrupted, starting over" << End;
+                return false;
+            }
+
+            this->m_IterationCount = iteration;
+            this->m_FinalValue = value;
+            this->m_FinalParameters = params;
+
+            Checkpointable* c = dynamic_cast<Checkpointable*>( this->getOptimizer() );
+            if ( c && optimizerLength > 0 && name == this->getOptimizer()->GetNameOfClass() )
+            {
+                StreamBuffer section;
+                sb.setOutPosition( optimizerPosition );
+                sb.streamOut( section.reset( optimizerLength ), optimizerLength );
+                c->restoreState( section );
+            }
+
+            EvaluationCache* cache = this->getMetric()->getEvaluationCache();
+            if ( cache && cacheLength > 0 )
+            {
+                StreamBuffer section;
+                sb.setOutPosition( cachePosition );
+                sb.streamOut( section.reset( cacheLength ), cacheLength );
+                cache->restoreState( section );
+            }
+
+            if ( this->m_IterationCount > 0 )
+            {
+                this->getMetric()->setIncumbentValue( this->m_FinalValue );
+            }
+
+            getSystemLogger() << StartInfo(this->GetNameOfClass()) << "restoreCheckpoint(): resuming after iteration " << this->m_IterationCount << ", best value = " << this->m_FinalValue << End;
+            return true;
+        }
+
+        /** Return the signature at the beginning of checkpoint files. */
+        static const char* getCheckpointSignature() { return "szi::SystemParametersTuner checkpoint 1"; }
 
     private:
         SystemParametersTuner( const Self & ); // purposely not implemented
@@ -160,6 +372,12 @@ namespace szi
         double m_FinalValue;
 
         int m_IterationCount;
+
+        OptimizerValueTracker m_ValueTracker;
+
+        std::string m_CheckpointFileName;
+        unsigned int m_CheckpointInterval;
+        bool m_Resume;
     };
 
 } // namespace szi
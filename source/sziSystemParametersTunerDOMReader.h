@@ -128,6 +128,25 @@ namespace szi
             	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "GenerateData(): System tuning monitor is not available!" << End;
             }
 
+            // read the checkpoint settings
+            itk::FancyString s;
+
+            s = inputdom->GetAttribute( "CheckpointFileName" );
+            if ( s != "" )
+            {
+                output->setCheckpointFileName( s );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): CheckpointFileName = " << s << End;
+            }
+
+            s = inputdom->GetAttribute( "CheckpointInterval" );
+            if ( s != "" )
+            {
+                unsigned int n = 1;
+                s >> n;
+                output->setCheckpointInterval( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): CheckpointInterval = " << n << End;
+            }
+
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): -----e-n-d-----" << End;
         }
 
@@ -4,7 +4,15 @@
 #include <itkSingleValuedCostFunction.h>
 
 #include "sziSystem.h"
+#include "sziBatchCostFunction.h"
 #include "sziDataSet.h"
+#include "sziEvaluationCache.h"
+
+#include <itkNumericTraits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace szi
 {
@@ -13,8 +21,18 @@ namespace szi
     Class to evaluate the performance of a system using a number of training examples.
     For each training example, a score is computed for the system, and the overall system performance
     is computed as the mean of the individual scores.
+    A number of parameter settings can be evaluated at once using GetValues(), in which case the
+    evaluations for all settings and all training examples are kept in progress together.
+    The individual scores are memoized in an evaluation cache, such that the (setting, example)
+    pairs that have been evaluated before, possibly by a previous run, are not evaluated again.
+    In racing mode, the evaluation of a setting is stopped as soon as its mean score cannot be lower
+    than the incumbent (the best mean score known so far) anymore, given a lower bound of the individual
+    scores; its value is then this lower bound of the mean, which is not lower than the incumbent either.
+    The training examples that have scored worst so far are evaluated first, to stop as early as possible.
+    In multi-fidelity mode, the batches of settings are screened at lower fidelities before the most
+    promising settings are evaluated at full fidelity.
     */
-    class SystemTrainingMetric : public itk::SingleValuedCostFunction
+    class SystemTrainingMetric : public itk::SingleValuedCostFunction, public BatchCostFunction
     {
     public:
         /** Standard class typedefs. */
@@ -35,7 +53,13 @@ namespace szi
         //
         typedef DataSet<SystemDataType> DataType;
         //
+        typedef Superclass::ParametersType ParametersType;
         typedef Superclass::MeasureType MeasureType;
+        //
+        typedef BatchCostFunction::ParametersListType ParametersListType;
+        typedef BatchCostFunction::MeasureListType MeasureListType;
+        //
+        typedef SystemType::EvaluationPointer EvaluationPointer;
 
         virtual void setSystem( SystemType* system ) { this->m_System = system; }
         SystemType* getSystem() { return this->m_System; }
@@ -45,6 +69,10 @@ namespace szi
         DataType* getData() { return this->m_Data; }
         const DataType* getData() const { return this->m_Data; }
 
+        /** Set/get the cache of individual scores, or null to always evaluate the system. */
+        virtual void setEvaluationCache( EvaluationCache* cache ) { this->m_EvaluationCache = cache; }
+        EvaluationCache* getEvaluationCache() const { return this->m_EvaluationCache; }
+
         virtual void initialize()
         {
         	getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): =====start=====" << End;
@@ -70,6 +98,11 @@ namespace szi
             	getSystemLogger() << StartWarning(this->GetNameOfClass()) << "initialize(): number of parameters to be tuned is zero" << End;
             }
 
+            if ( this->m_EvaluationCache )
+            {
+                this->m_EvaluationCache->load();
+            }
+
             getSystemLogger() << StartInfo(this->GetNameOfClass()) << "initialize(): -----e-n-d-----" << End;
         }
 
@@ -81,35 +114,155 @@ namespace szi
 
         virtual MeasureType GetValue( const ParametersType& params ) const
         {
-            Self* self = const_cast<Self*>( this );
+            ParametersListType paramslist( 1, params );
+            MeasureListType values;
 
-            SystemType* system = self->getSystem();
+            this->GetValues( paramslist, values );
+
+            return values[0];
+        }
 
-            // compute the score for each training example, and then aggregate them
-            MeasureType value = 0;
+        /**
+        Compute the mean score over all training examples for each setting of parameters.
+        In multi-fidelity mode, the settings are screened by successive halving on the fidelities 1/eta^k,
+        k = K..0, where 1/eta^K is the lowest of them not below the minimum fidelity: all of them are evaluated
+        at 1/eta^K, only the best 1/eta of them are evaluated again at eta times that fidelity, and so on up to
+        the full fidelity. The settings eliminated on the way are given their last mean score, but
+        not lower than the worst full-fidelity mean score, such that they never rank before a promoted setting.
+        */
+        virtual void GetValues( const ParametersListType& params, MeasureListType& values ) const
+        {
+            this->GetValues( params, values, 0 );
+        }
 
-            // first, start score computation for each training example
-            for ( unsigned int i = 0; i < self->getData()->size(); i++ )
+        /** Compute the mean scores as GetValues(), telling the observer the value of each setting as soon as it is final. */
+        virtual void GetValues( const ParametersListType& params, MeasureListType& values, ValueObserver* observer ) const
+        {
+            const double eta = this->m_FidelityReductionFactor;
+            unsigned int rungs = this->getNumberOfScreeningFidelities();
+            if ( rungs == 0 || params.size() <= 1 )
             {
-                SystemDataType* data = self->getData()->at(i);
-                system->setData( data );
-                system->setTunableParameters( params );
-                system->updatePerformanceScore();
+                this->computeMeans( params, 1, values, observer );
+                return;
             }
 
-            // then, collect and sum individual scores
-            for ( unsigned int i = 0; i < self->getData()->size(); i++ )
+            values.assign( params.size(), 0 );
+
+            // indices of the settings still in the race, and of the eliminated ones
+            std::vector<unsigned int> alive( params.size() );
+            for ( unsigned int k = 0; k < alive.size(); k++ ) alive[k] = k;
+            std::vector<unsigned int> eliminated;
+
+            for ( int rung = rungs; ; rung-- )
             {
-                SystemDataType* data = self->getData()->at(i);
-                system->setData( data );
-                MeasureType score = system->getPerformanceScore();
-                value += score;
+                double fidelity = ( rung > 0 ? std::pow( eta, -(double)rung ) : 1.0 );
+
+                ParametersListType subset( alive.size() );
+                for ( unsigned int k = 0; k < alive.size(); k++ ) subset[k] = params[ alive[k] ];
+
+                // only the values of the full-fidelity evaluation are final
+                SubsetObserver subsetObserver( observer, alive );
+                MeasureListType means;
+                this->computeMeans( subset, fidelity, means, ( rung == 0 && observer ? &subsetObserver : 0 ) );
+                for ( unsigned int k = 0; k < alive.size(); k++ ) values[ alive[k] ] = means[k];
+
+                if ( rung == 0 ) break;
+
+                // promote the best settings to the next fidelity
+                unsigned int keep = (unsigned int)std::ceil( alive.size() / eta );
+                if ( keep < 1 ) keep = 1;
+                std::stable_sort( alive.begin(), alive.end(), LowerValue( values ) );
+                eliminated.insert( eliminated.end(), alive.begin() + keep, alive.end() );
+                alive.resize( keep );
+
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GetValues(): " << keep << " of " << params.size() << " settings promoted after fidelity " << fidelity << End;
+            }
+
+            MeasureType worst = values[ alive[0] ];
+            for ( unsigned int k = 1; k < alive.size(); k++ )
+            {
+                if ( values[ alive[k] ] > worst ) worst = values[ alive[k] ];
             }
+            for ( unsigned int k = 0; k < eliminated.size(); k++ )
+            {
+                if ( values[ eliminated[k] ] < worst ) values[ eliminated[k] ] = worst;
+                if ( observer ) observer->valueComputed( eliminated[k], values[ eliminated[k] ] );
+            }
+        }
 
-            // finally, compute the average
-            value /= (MeasureType)self->getData()->size();
+        /** Return false in racing or multi-fidelity mode, where the values of some settings are bounds or screening scores. */
+        virtual bool getValuesAreExact() const
+        {
+            return ( !this->m_Racing && this->getNumberOfScreeningFidelities() == 0 );
+        }
 
-            return value;
+        /** Return the number K of fidelities 1/eta^k, k = K..1, at which the settings are screened before the full fidelity. */
+        unsigned int getNumberOfScreeningFidelities() const
+        {
+            unsigned int rungs = 0;
+            while ( std::pow( this->m_FidelityReductionFactor, -(double)( rungs + 1 ) ) >= this->m_MinimumFidelity * ( 1 - 1e-9 ) ) rungs++;
+            return rungs;
+        }
+
+        /**
+        Set/get the lowest fidelity at which the settings may be screened in multi-fidelity mode, in (0,1]
+        (1 by default, i.e. no screening), see Tunable::setFidelity().
+        */
+        virtual void setMinimumFidelity( double fidelity ) { this->m_MinimumFidelity = ( fidelity > 0 && fidelity < 1 ? fidelity : 1 ); }
+        double getMinimumFidelity() const { return this->m_MinimumFidelity; }
+
+        /** Set/get the factor eta by which the number of settings is reduced, and the fidelity increased, at each step (3 by default). */
+        virtual void setFidelityReductionFactor( double eta ) { this->m_FidelityReductionFactor = ( eta > 1 ? eta : 3 ); }
+        double getFidelityReductionFactor() const { return this->m_FidelityReductionFactor; }
+
+        /**
+        Set/get whether the evaluation of a setting is stopped as soon as it cannot beat the incumbent (off by default).
+        Racing requires a lower bound of the individual scores, see setScoreLowerBound().
+        */
+        virtual void setRacing( bool racing ) { this->m_Racing = racing; }
+        bool getRacing() const { return this->m_Racing; }
+
+        /** Set/get the lowest possible individual score (0 by default, e.g. for the complement of the Kappa statistic). */
+        virtual void setScoreLowerBound( MeasureType score ) { this->m_ScoreLowerBound = score; }
+        MeasureType getScoreLowerBound() const { return this->m_ScoreLowerBound; }
+
+        /**
+        Set the incumbent, i.e. the best (lowest) mean score known so far, e.g. by the tuner. The metric also
+        updates it with the mean scores it computes; the incumbent is unknown until either happens.
+        */
+        virtual void setIncumbentValue( MeasureType value )
+        {
+            if ( !this->m_HasIncumbent || value < this->m_IncumbentValue )
+            {
+                this->m_IncumbentValue = value;
+                this->m_HasIncumbent = true;
+            }
+        }
+        MeasureType getIncumbentValue() const { return this->m_IncumbentValue; }
+        bool getHasIncumbent() const { return this->m_HasIncumbent; }
+
+        /** Return the number of individual scores computed by the system, and the number skipped by racing. */
+        unsigned long getNumberOfEvaluations() const { return this->m_NumberOfEvaluations; }
+        unsigned long getNumberOfSkippedEvaluations() const { return this->m_NumberOfSkippedEvaluations; }
+
+        /**
+        Set/get the maximum number of evaluations being in progress at the same time.
+        Zero (the default) means no limit: all evaluations are submitted at once, the system
+        blocking the submission while all of its resources are busy, and the evaluations being
+        collected as they finish. In racing mode, the limit is at most the number of evaluations
+        the system can run at the same time, such that stopped settings are not submitted further.
+        */
+        virtual void setMaximumNumberOfConcurrentEvaluations( unsigned int n ) { this->m_MaximumNumberOfConcurrentEvaluations = n; }
+        unsigned int getMaximumNumberOfConcurrentEvaluations() const { return this->m_MaximumNumberOfConcurrentEvaluations; }
+
+        /** Return the number of evaluations that will be in progress at the same time. */
+        unsigned int getNumberOfConcurrentEvaluations() const
+        {
+            if ( this->m_MaximumNumberOfConcurrentEvaluations > 0 )
+            {
+                return this->m_MaximumNumberOfConcurrentEvaluations;
+            }
+            return itk::NumericTraits<unsigned int>::max();
         }
 
         virtual void GetDerivative( const ParametersType& params, DerivativeType& deriv ) const
@@ -118,7 +271,272 @@ namespace szi
         }
 
     protected:
-        SystemTrainingMetric() {}
+        SystemTrainingMetric() : m_MaximumNumberOfConcurrentEvaluations(0), m_Racing(false), m_ScoreLowerBound(0),
+                                 m_IncumbentValue(0), m_HasIncumbent(false), m_NumberOfEvaluations(0), m_NumberOfSkippedEvaluations(0),
+                                 m_MinimumFidelity(1), m_FidelityReductionFactor(3)
+        {
+            this->m_EvaluationCache = EvaluationCache::New();
+        }
+
+        /**
+        Compute the mean score over all training examples for each setting of parameters, at a fidelity.
+        All (setting, example) pairs are submitted to the system as one stream of evaluations,
+        the training examples that took the longest time so far being submitted first, or in racing
+        mode, the training examples that scored worst so far. Only the full-fidelity scores are cached,
+        used for racing, and taken into account for ordering. The observer, if not null, is told the
+        value of each setting as soon as all of its scores are known, or at the end if it has been stopped.
+        */
+        void computeMeans( const ParametersListType& params, double fidelity, MeasureListType& values, ValueObserver* observer ) const
+        {
+            Self* self = const_cast<Self*>( this );
+
+            SystemType* system = self->getSystem();
+            DataType* examples = self->getData();
+
+            unsigned int nexamples = examples->size();
+            bool full = ( fidelity >= 1 );
+            EvaluationCache* cache = ( full ? this->m_EvaluationCache.GetPointer() : 0 );
+            bool racing = ( full && this->m_Racing );
+
+            // number of evaluations to be kept in progress at the same time; in racing mode, no more than the
+            // system can run at once, such that the evaluations of the settings stopped meanwhile are not submitted
+            unsigned int window = this->getNumberOfConcurrentEvaluations();
+            if ( racing && window > system->getNumberOfConcurrentEvaluations() )
+            {
+                window = system->getNumberOfConcurrentEvaluations();
+            }
+            unsigned long skipped = this->m_NumberOfSkippedEvaluations;
+
+            if ( self->m_ExampleScores.size() != nexamples )
+            {
+                self->m_ExampleScores.assign( nexamples, 0 );
+                self->m_ExampleCounts.assign( nexamples, 0 );
+            }
+
+            // sums of the individual scores, and number of them, per setting
+            values.assign( params.size(), 0 );
+            std::vector<unsigned int> counts( params.size(), 0 );
+
+            // take the scores of the (setting, example) pairs evaluated before from the cache
+            std::vector<unsigned int> order;
+            order.reserve( params.size() * nexamples );
+            for ( unsigned int k = 0; k < params.size() * nexamples; k++ )
+            {
+                MeasureType score = 0;
+                if ( cache && cache->find( examples->at(k % nexamples), params[k / nexamples], score ) )
+                {
+                    values[k / nexamples] += score;
+                    counts[k / nexamples]++;
+                }
+                else
+                {
+                    order.push_back( k );
+                }
+            }
+            unsigned int n = order.size();
+
+            // settings whose value has been told to the observer, starting with those completely in the cache
+            std::vector<bool> notified( params.size(), false );
+            for ( unsigned int s = 0; observer && s < params.size(); s++ )
+            {
+                if ( counts[s] == nexamples )
+                {
+                    observer->valueComputed( s, values[s] / (MeasureType)nexamples );
+                    notified[s] = true;
+                }
+            }
+
+            if ( racing )
+            {
+                // order the remaining pairs by decreasing mean score of the examples so far, such that the
+                // hopeless settings are found early; the settings remain interleaved for each example
+                std::vector<double> means( nexamples, 0 );
+                for ( unsigned int k = 0; k < nexamples; k++ )
+                {
+                    if ( this->m_ExampleCounts[k] ) means[k] = this->m_ExampleScores[k] / this->m_ExampleCounts[k];
+                }
+                std::stable_sort( order.begin(), order.end(), LongerEvaluation( means ) );
+            }
+            else
+            {
+                // order the remaining pairs by decreasing estimated time of the examples
+                std::vector<double> times( nexamples );
+                for ( unsigned int k = 0; k < nexamples; k++ )
+                {
+                    times[k] = system->getEstimatedEvaluationTime( examples->at(k) );
+                }
+                std::stable_sort( order.begin(), order.end(), LongerEvaluation( times ) );
+            }
+
+            // settings whose evaluation has been stopped by racing
+            std::vector<bool> stopped( params.size(), false );
+            if ( racing )
+            {
+                for ( unsigned int s = 0; s < params.size(); s++ )
+                {
+                    self->updateRace( s, values, counts, stopped, nexamples );
+                }
+            }
+
+            // compute the score for each (setting, example) pair, and then aggregate them per setting
+            std::vector<EvaluationPointer> evaluations( n );
+            unsigned int next = 0;
+            for ( unsigned int i = 0; i < n; i++ )
+            {
+                // keep the pipeline full by starting score computation for the following pairs
+                for ( ; next < n && next - i < window; next++ )
+                {
+                    unsigned int k = order[next];
+                    if ( stopped[k / nexamples] ) continue;
+                    evaluations[next] = system->submitEvaluation( examples->at(k % nexamples), params[k / nexamples], fidelity );
+                }
+
+                unsigned int k = order[i];
+                unsigned int s = k / nexamples;
+                if ( !evaluations[i] )
+                {
+                    self->m_NumberOfSkippedEvaluations++;
+                    continue;
+                }
+
+                // collect the individual score, and sum it up
+                MeasureType score = system->waitEvaluation( evaluations[i] );
+                values[s] += score;
+                counts[s]++;
+                evaluations[i] = 0;
+                self->m_NumberOfEvaluations++;
+
+                if ( full )
+                {
+                    self->m_ExampleScores[k % nexamples] += score;
+                    self->m_ExampleCounts[k % nexamples]++;
+                }
+
+                if ( cache )
+                {
+                    cache->insert( examples->at(k % nexamples), params[s], score );
+                }
+
+                if ( observer && counts[s] == nexamples )
+                {
+                    observer->valueComputed( s, values[s] / (MeasureType)nexamples );
+                    notified[s] = true;
+                }
+
+                if ( racing )
+                {
+                    bool improved = self->updateRace( s, values, counts, stopped, nexamples );
+                    for ( unsigned int t = 0; improved && t < params.size(); t++ )
+                    {
+                        self->updateRace( t, values, counts, stopped, nexamples );
+                    }
+
+                    // give up the evaluations in progress for the settings that have been stopped
+                    for ( unsigned int j = i + 1; j < next; j++ )
+                    {
+                        if ( evaluations[j] && stopped[ order[j] / nexamples ] )
+                        {
+                            system->cancelEvaluation( evaluations[j] );
+                            evaluations[j] = 0;
+                        }
+                    }
+                }
+            }
+
+            if ( racing )
+            {
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "computeMeans(): racing skipped " << ( this->m_NumberOfSkippedEvaluations - skipped ) << " of " << n << " evaluations, " << this->m_NumberOfSkippedEvaluations << " in total" << End;
+            }
+
+            // finally, compute the averages, or the lower bounds for the stopped settings
+            for ( unsigned int s = 0; s < values.size(); s++ )
+            {
+                if ( stopped[s] )
+                {
+                    values[s] = this->getMeanLowerBound( values[s], counts[s], nexamples );
+                }
+                else
+                {
+                    values[s] /= (MeasureType)nexamples;
+                }
+
+                if ( observer && !notified[s] )
+                {
+                    observer->valueComputed( s, values[s] );
+                }
+            }
+        }
+
+        /** Return the lowest possible mean score of a setting, given the sum of its first scores. */
+        MeasureType getMeanLowerBound( MeasureType sum, unsigned int count, unsigned int nexamples ) const
+        {
+            return ( sum + ( nexamples - count ) * this->m_ScoreLowerBound ) / (MeasureType)nexamples;
+        }
+
+        /**
+        Update the race of a setting after a new score: record its mean score as the incumbent if it is
+        complete and better, or stop it if it cannot beat the incumbent anymore. Return true if the
+        incumbent has improved.
+        */
+        bool updateRace( unsigned int s, const MeasureListType& sums, const std::vector<unsigned int>& counts,
+                         std::vector<bool>& stopped, unsigned int nexamples )
+        {
+            if ( stopped[s] ) return false;
+
+            if ( counts[s] == nexamples )
+            {
+                MeasureType value = sums[s] / (MeasureType)nexamples;
+                bool improved = ( !this->m_HasIncumbent || value < this->m_IncumbentValue );
+                this->setIncumbentValue( value );
+                return improved;
+            }
+
+            if ( this->m_HasIncumbent && this->getMeanLowerBound( sums[s], counts[s], nexamples ) >= this->m_IncumbentValue )
+            {
+                stopped[s] = true;
+            }
+            return false;
+        }
+
+        /** Observer of the values of a subset of settings, telling them to another observer under their indices in the whole set. */
+        struct SubsetObserver : public ValueObserver
+        {
+            ValueObserver* m_Observer;
+            const std::vector<unsigned int>& m_Indices;
+
+            SubsetObserver( ValueObserver* observer, const std::vector<unsigned int>& indices ) : m_Observer(observer), m_Indices(indices) {}
+
+            virtual void valueComputed( unsigned int i, MeasureType value )
+            {
+                this->m_Observer->valueComputed( this->m_Indices[i], value );
+            }
+        };
+
+        /** Comparison of settings by increasing value. */
+        struct LowerValue
+        {
+            const MeasureListType& m_Values;
+
+            LowerValue( const MeasureListType& values ) : m_Values(values) {}
+
+            bool operator()( unsigned int a, unsigned int b ) const
+            {
+                return this->m_Values[a] < this->m_Values[b];
+            }
+        };
+
+        /** Comparison of (setting, example) pairs by decreasing key (e.g. estimated time) of their examples. */
+        struct LongerEvaluation
+        {
+            const std::vector<double>& m_Times;
+
+            LongerEvaluation( const std::vector<double>& times ) : m_Times(times) {}
+
+            bool operator()( unsigned int a, unsigned int b ) const
+            {
+                return this->m_Times[ a % this->m_Times.size() ] > this->m_Times[ b % this->m_Times.size() ];
+            }
+        };
 
     private:
         SystemTrainingMetric( const Self & ); // purposely not implemented
@@ -126,6 +544,25 @@ namespace szi
 
         SystemType::Pointer m_System;
         DataType::Pointer m_Data;
+
+        unsigned int m_MaximumNumberOfConcurrentEvaluations;
+
+        EvaluationCache::Pointer m_EvaluationCache;
+
+        bool m_Racing;
+        MeasureType m_ScoreLowerBound;
+        MeasureType m_IncumbentValue;
+        bool m_HasIncumbent;
+
+        /** Sum and number of the scores computed so far for each training example. */
+        std::vector<double> m_ExampleScores;
+        std::vector<unsigned int> m_ExampleCounts;
+
+        unsigned long m_NumberOfEvaluations;
+        unsigned long m_NumberOfSkippedEvaluations;
+
+        double m_MinimumFidelity;
+        double m_FidelityReductionFactor;
     };
 
 } // namespace szi
@@ -4,6 +4,8 @@
 #include <itkDOMReader.h>
 #include "sziSystemTrainingMetric.h"
 
+#include "sziLogService.h"
+
 namespace szi
 {
 
@@ -45,6 +47,78 @@ namespace szi
             }
 
             // read data fields
+
+            itk::FancyString s;
+
+            s = inputdom->GetAttribute( "MaximumNumberOfConcurrentEvaluations" );
+            if ( s != "" )
+            {
+                unsigned int n = 0;
+                s >> n;
+                output->setMaximumNumberOfConcurrentEvaluations( n );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): MaximumNumberOfConcurrentEvaluations = " << n << End;
+            }
+
+            s = inputdom->GetAttribute( "Racing" );
+            if ( s == "1" || s == "on" )
+            {
+                output->setRacing( true );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): Racing = on" << End;
+            }
+
+            s = inputdom->GetAttribute( "ScoreLowerBound" );
+            if ( s != "" )
+            {
+                double score = 0;
+                s >> score;
+                output->setScoreLowerBound( score );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): ScoreLowerBound = " << score << End;
+            }
+
+            s = inputdom->GetAttribute( "MinimumFidelity" );
+            if ( s != "" )
+            {
+                double fidelity = 1;
+                s >> fidelity;
+                output->setMinimumFidelity( fidelity );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): MinimumFidelity = " << output->getMinimumFidelity() << End;
+            }
+
+            s = inputdom->GetAttribute( "FidelityReductionFactor" );
+            if ( s != "" )
+            {
+                double eta = 0;
+                s >> eta;
+                output->setFidelityReductionFactor( eta );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): FidelityReductionFactor = " << output->getFidelityReductionFactor() << End;
+            }
+
+            s = inputdom->GetAttribute( "EvaluationCache" );
+            if ( s == "0" || s == "off" )
+            {
+                output->setEvaluationCache( 0 );
+                getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): EvaluationCache = off" << End;
+            }
+
+            EvaluationCache* cache = output->getEvaluationCache();
+            if ( cache )
+            {
+                s = inputdom->GetAttribute( "EvaluationCacheFile" );
+                if ( s != "" )
+                {
+                    cache->setFileName( s );
+                    getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): EvaluationCacheFile = " << s << End;
+                }
+
+                s = inputdom->GetAttribute( "EvaluationCacheQuantizationStep" );
+                if ( s != "" )
+                {
+                    double step = 0;
+                    s >> step;
+                    cache->setQuantizationStep( step );
+                    getSystemLogger() << StartInfo(this->GetNameOfClass()) << "GenerateData(): EvaluationCacheQuantizationStep = " << step << End;
+                }
+            }
         }
 
     private:
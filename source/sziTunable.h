@@ -3,6 +3,7 @@
 
 #include <itkSingleValuedCostFunction.h>
 #include <itkEventObject.h>
+#include "sziCancellationToken.h"
 
 namespace szi
 {
@@ -37,6 +38,32 @@ namespace szi
         */
         virtual void updatePerformanceScore() = 0;
 
+        /**
+        Set/get the fidelity of the performance score, i.e. the fraction of the full computation to spend on it,
+        in (0,1] (1 by default). Subclasses may compute a cheaper, approximate score at a lower fidelity, e.g. by
+        reducing the number of iterations of an optimizer, to screen settings before computing their full scores.
+        */
+        virtual void setFidelity( double fidelity ) { this->m_Fidelity = ( fidelity > 0 && fidelity < 1 ? fidelity : 1 ); }
+        double getFidelity() const { return this->m_Fidelity; }
+
+        /** Return a count (e.g. of iterations or samples) reduced according to the fidelity, at least 1. */
+        unsigned long getReducedCount( unsigned long n ) const
+        {
+            if ( this->m_Fidelity >= 1 || n == 0 ) return n;
+            unsigned long reduced = (unsigned long)( n * this->m_Fidelity + 0.5 );
+            return ( reduced > 0 ? reduced : 1 );
+        }
+
+        /**
+        Set/get the token checked by updatePerformanceScore() to stop early when the score is no longer needed,
+        e.g. at each iteration of an optimizer; subclasses should forward it to the tunable parts they use.
+        */
+        virtual void setCancellationToken( CancellationToken* token ) { this->m_CancellationToken = token; }
+        CancellationToken* getCancellationToken() const { return this->m_CancellationToken; }
+
+        /** Return true if the computation of the performance score has been requested to stop. */
+        bool isCancelled() const { return ( this->m_CancellationToken && this->m_CancellationToken->isCancelled() ); }
+
         /**
         Abstract methods to be extended or reimplemented in subclasses of tunable systems
         to set/get the current performance score.
@@ -44,12 +71,14 @@ namespace szi
         virtual void setPerformanceScore( MeasureType score ) { this->m_PerformanceScore = score; }
         virtual MeasureType getPerformanceScore() const { return this->m_PerformanceScore; }
 
-        Tunable() : m_PerformanceScore( 0 ) {}
+        Tunable() : m_PerformanceScore( 0 ), m_Fidelity( 1 ) {}
         virtual ~Tunable() {}
 
     private:
         ParametersType m_TunableParameters;
         MeasureType m_PerformanceScore;
+        double m_Fidelity;
+        CancellationToken::Pointer m_CancellationToken;
     };
 
 } // namespace szi
@@ -0,0 +1,84 @@
+#ifndef _sziTunableRegistrationMethod_h_
+#define _sziTunableRegistrationMethod_h_
+
+#include <itkImageRegistrationMethod.h>
+#include "sziTunable.h"
+
+#include <itkRegularStepGradientDescentOptimizer.h>
+#include <itkCommand.h>
+
+namespace szi
+{
+
+    /**
+    Base class of the tunable registrations, i.e. image registration methods whose performance score is
+    computed by updatePerformanceScore(). It provides subclasses with the means to honour the fidelity and
+    the cancellation token of Tunable: reducing the samples of a metric at a lower fidelity, and stopping
+    the optimizer at its next iteration once the performance score is no longer needed.
+    */
+    template < typename TFixedImage, typename TMovingImage, typename TOptimizer = itk::RegularStepGradientDescentOptimizer >
+    class TunableRegistrationMethod : public itk::ImageRegistrationMethod<TFixedImage,TMovingImage>, public Tunable
+    {
+    public:
+        /** Standard class typedefs. */
+        typedef TunableRegistrationMethod Self;
+        typedef itk::ImageRegistrationMethod<TFixedImage,TMovingImage> Superclass;
+        typedef itk::SmartPointer< Self > Pointer;
+        typedef itk::SmartPointer< const Self > ConstPointer;
+
+        /** Run-time type information (and related methods). */
+        itkTypeMacro( szi::TunableRegistrationMethod, ImageRegistrationMethod );
+
+        typedef TOptimizer OptimizerType;
+        typedef typename Superclass::MetricType MetricType;
+
+    protected:
+        /** Add an observer to stop the optimizer when the performance score is no longer needed, and return its tag. */
+        unsigned long observeCancellation( OptimizerType* optimizer )
+        {
+            typedef itk::SimpleMemberCommand<Self> CommandType;
+            typename CommandType::Pointer command = CommandType::New();
+            command->SetCallbackFunction( this, &Self::stopIfCancelled );
+            return optimizer->AddObserver( itk::IterationEvent(), command );
+        }
+
+        /** Reduce the number of samples used by a metric according to the fidelity, and return the full number. */
+        unsigned long reduceSamples( MetricType* metric )
+        {
+            unsigned long samples = metric->GetNumberOfFixedImageSamples();
+            if ( !metric->GetUseAllPixels() )
+            {
+                metric->SetNumberOfFixedImageSamples( this->getReducedCount( samples ) );
+            }
+            return samples;
+        }
+
+        /** Restore the full number of samples used by a metric. */
+        void restoreSamples( MetricType* metric, unsigned long samples )
+        {
+            if ( metric->GetNumberOfFixedImageSamples() != samples )
+            {
+                metric->SetNumberOfFixedImageSamples( samples );
+            }
+        }
+
+        /** Stop the optimizer if the performance score is no longer needed, called at each iteration. */
+        void stopIfCancelled()
+        {
+            OptimizerType* optimizer = dynamic_cast<OptimizerType*>( this->GetOptimizer() );
+            if ( optimizer && this->isCancelled() )
+            {
+                optimizer->StopOptimization();
+            }
+        }
+
+        TunableRegistrationMethod() {}
+
+    private:
+        TunableRegistrationMethod( const Self & ); // purposely not implemented
+        TunableRegistrationMethod& operator=( const Self & ); // purposely not implemented
+    };
+
+} // namespace szi
+
+#endif // _sziTunableRegistrationMethod_h_